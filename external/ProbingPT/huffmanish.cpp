@@ -219,10 +219,16 @@ HuffmanDecoder::HuffmanDecoder (std::map<unsigned int, std::string> * lookup_tar
   lookup_word_all1 = *lookup_word1;
 }
 
-std::vector<target_text> HuffmanDecoder::full_decode_line (std::vector<unsigned char> lines, int num_scores)
+std::vector<target_text> HuffmanDecoder::full_decode_line (std::vector<unsigned char> lines, int num_scores) const
+{
+  const unsigned char * begin = lines.empty() ? NULL : &lines[0];
+  return full_decode_line(begin, begin + lines.size(), num_scores);
+}
+
+std::vector<target_text> HuffmanDecoder::full_decode_line (const unsigned char * begin, const unsigned char * end, int num_scores) const
 {
   std::vector<target_text> retvector; //All target phrases
-  std::vector<unsigned int> decoded_lines = vbyte_decode_line(lines); //All decoded lines
+  std::vector<unsigned int> decoded_lines = vbyte_decode_line(begin, end); //All decoded lines
   std::vector<unsigned int>::iterator it = decoded_lines.begin(); //Iterator for them
   std::vector<unsigned int> current_target_phrase; //Current target phrase decoded
 
@@ -263,7 +269,7 @@ std::vector<target_text> HuffmanDecoder::full_decode_line (std::vector<unsigned
 
 }
 
-target_text HuffmanDecoder::decode_line (std::vector<unsigned int> input, int num_scores)
+target_text HuffmanDecoder::decode_line (std::vector<unsigned int> input, int num_scores) const
 {
   //demo decoder
   target_text ret;
@@ -422,6 +428,25 @@ std::vector<unsigned int> vbyte_decode_line(std::vector<unsigned char> line)
   return huffman_line;
 }
 
+std::vector<unsigned int> vbyte_decode_line(const unsigned char * begin, const unsigned char * end)
+{
+  std::vector<unsigned int> huffman_line;
+  unsigned int current_num = 0;
+  unsigned char shift = 0; //By how many bits to shift
+
+  for (const unsigned char * it = begin; it != end; it++) {
+    current_num |= (*it & 0x7f) << shift;
+    shift += 7;
+    if ((*it >> 7) != 1) {
+      //We don't have continuation in the next bit
+      huffman_line.push_back(current_num);
+      current_num = 0;
+      shift = 0;
+    }
+  }
+  return huffman_line;
+}
+
 inline unsigned int bytes_to_int(std::vector<unsigned char> number)
 {
   unsigned int retvalue = 0;
@@ -92,10 +92,12 @@ public:
 
   std::string getTargetWordsFromIDs(std::vector<unsigned int> ids);
 
-  target_text decode_line (std::vector<unsigned int> input, int num_scores);
+  target_text decode_line (std::vector<unsigned int> input, int num_scores) const;
 
   //Variable byte decodes a all target phrases contained here and then passes them to decode_line
-  std::vector<target_text> full_decode_line (std::vector<unsigned char> lines, int num_scores);
+  std::vector<target_text> full_decode_line (std::vector<unsigned char> lines, int num_scores) const;
+  //Same, but decodes the bytes in [begin, end) in place, e.g. straight from the mapped table
+  std::vector<target_text> full_decode_line (const unsigned char * begin, const unsigned char * end, int num_scores) const;
 };
 
 std::string getTargetWordsFromIDs(std::vector<unsigned int> ids, std::map<unsigned int, std::string> * lookup_target_phrase);
@@ -109,4 +111,5 @@ inline float reinterpret_uint(unsigned int * num);
 std::vector<unsigned char> vbyte_encode_line(std::vector<unsigned int> line);
 inline std::vector<unsigned char> vbyte_encode(unsigned int num);
 std::vector<unsigned int> vbyte_decode_line(std::vector<unsigned char> line);
+std::vector<unsigned int> vbyte_decode_line(const unsigned char * begin, const unsigned char * end);
 inline unsigned int bytes_to_int(std::vector<unsigned char> number);
@@ -37,6 +37,12 @@ QueryEngine::QueryEngine(const char * filepath) : decoder(filepath)
 
   //Target phrase vocabIDs
   vocabids = decoder.get_target_lookup_map();
+  if (!vocabids.empty()) {
+    target_words.resize(vocabids.rbegin()->first + 1);
+    for (std::map<unsigned int, std::string>::const_iterator it = vocabids.begin(); it != vocabids.end(); it++) {
+      target_words[it->first] = it->second;
+    }
+  }
 
   //Read config file
   std::string line;
@@ -126,6 +132,24 @@ std::pair<bool, std::vector<target_text> > QueryEngine::query(std::vector<uint64
 
 }
 
+bool QueryEngine::query(const uint64_t * source_ids, size_t length, std::vector<target_text> & translation_entries) const
+{
+  const Entry * entry;
+  uint64_t key = 0;
+  for (size_t i = 0; i < length; i++) {
+    key += (source_ids[i] << i);
+  }
+
+  if (!table.Find(key, entry)) {
+    return false;
+  }
+
+  //Decode straight from the mapped file.
+  const unsigned char * begin = binary_mmaped + entry -> GetValue();
+  translation_entries = decoder.full_decode_line(begin, begin + entry -> bytes_toread, num_scores);
+  return true;
+}
+
 std::pair<bool, std::vector<target_text> > QueryEngine::query(StringPiece source_phrase)
 {
   bool found;
@@ -15,6 +15,7 @@ class QueryEngine
 {
   unsigned char * binary_mmaped; //The binari phrase table file
   std::map<unsigned int, std::string> vocabids;
+  std::vector<std::string> target_words; //vocabids as a flat array indexed by ID
   std::map<uint64_t, std::string> source_vocabids;
 
   Table table;
@@ -31,6 +32,13 @@ public:
   ~QueryEngine();
   std::pair<bool, std::vector<target_text> > query(StringPiece source_phrase);
   std::pair<bool, std::vector<target_text> > query(std::vector<uint64_t> source_phrase);
+  //Takes the vocabulary IDs (getHash) of the source words, so that no strings
+  //need to be built. Returns false if the phrase is not in the table.
+  bool query(const uint64_t * source_ids, size_t length, std::vector<target_text> & translation_entries) const;
+  //The word of an ID in target_text::target_phrase
+  const std::string & getTargetWord(unsigned int id) const {
+    return target_words[id];
+  }
   void printTargetInfo(std::vector<target_text> target_phrases);
   const std::map<unsigned int, std::string> getVocab() const {
     return decoder.get_target_lookup_map();
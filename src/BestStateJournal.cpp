@@ -0,0 +1,73 @@
+/*
+ *  BestStateJournal.cpp
+ *
+ *  Copyright 2012 by Christian Hardmeier. All rights reserved.
+ *
+ *  This file is part of Docent, a document-level decoder for phrase-based
+ *  statistical machine translation.
+ *
+ *  Docent is free software: you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation, either version 3 of the License, or (at your option) any later
+ *  version.
+ *
+ *  Docent is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  Docent. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BestStateJournal.h"
+
+#include "NbestStorage.h"
+#include "SearchStep.h"
+
+#include <boost/foreach.hpp>
+#include <boost/make_shared.hpp>
+
+BestStateJournal::BestStateJournal(
+	const DocumentState &doc
+) :	bestSentences_(doc.getPhraseSegmentations()),
+	bestScore_(doc.getScore()),
+	bestGeneration_(doc.getGeneration()),
+	isPending_(bestSentences_.size(), false),
+	offered_(false)
+{}
+
+void BestStateJournal::recordStep(const SearchStep &step) {
+	BOOST_FOREACH(const SearchStep::Modification &mod, step.getModifications())
+		if(!isPending_[mod.sentno]) {
+			isPending_[mod.sentno] = true;
+			pending_.push_back(mod.sentno);
+		}
+}
+
+void BestStateJournal::update(const DocumentState &doc) {
+	if(doc.getScore() <= bestScore_)
+		return;
+
+	BOOST_FOREACH(uint sentno, pending_) {
+		bestSentences_.share(sentno, doc.getPhraseSegmentations());
+		isPending_[sentno] = false;
+	}
+	pending_.clear();
+
+	bestScore_ = doc.getScore();
+	bestGeneration_ = doc.getGeneration();
+	offered_ = false;
+}
+
+void BestStateJournal::offerBest(const boost::shared_ptr<DocumentState> &doc, NbestStorage &nbest) {
+	if(offered_)
+		return;
+
+	if(doc->getGeneration() == bestGeneration_)
+		nbest.offer(doc);
+	else
+		nbest.offer(boost::make_shared<DocumentState>(*doc, bestSentences_, bestGeneration_));
+
+	offered_ = true;
+}
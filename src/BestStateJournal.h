@@ -0,0 +1,72 @@
+/*
+ *  BestStateJournal.h
+ *
+ *  Copyright 2012 by Christian Hardmeier. All rights reserved.
+ *
+ *  This file is part of Docent, a document-level decoder for phrase-based
+ *  statistical machine translation.
+ *
+ *  Docent is free software: you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation, either version 3 of the License, or (at your option) any later
+ *  version.
+ *
+ *  Docent is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  Docent. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef docent_BestStateJournal_h
+#define docent_BestStateJournal_h
+
+#include "Docent.h"
+#include "DocumentState.h"
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+class NbestStorage;
+class SearchStep;
+
+/**
+ * Keeps track of the best state a document has been in without copying the
+ * document state every time the score improves. The journal records which
+ * sentences the accepted steps modify. When the score reaches a new maximum,
+ * it takes references to the current versions of those sentences. The full
+ * document state for the best score is only built when it is offered to an
+ * n-best list, and the feature function states are then computed from
+ * scratch.
+ */
+class BestStateJournal {
+private:
+	PhraseSegmentationVector bestSentences_;
+	Float bestScore_;
+	DocumentGeneration bestGeneration_;
+	std::vector<uint> pending_;
+	std::vector<bool> isPending_;
+	bool offered_;
+
+public:
+	BestStateJournal(const DocumentState &doc);
+
+	// Must be called for every accepted step before it is applied.
+	void recordStep(const SearchStep &step);
+
+	// Must be called after applying an accepted step.
+	void update(const DocumentState &doc);
+
+	Float getBestScore() const {
+		return bestScore_;
+	}
+
+	// Offers the best state seen so far to nbest unless that has already
+	// been done. doc must be the state the journal has been tracking.
+	void offerBest(const boost::shared_ptr<DocumentState> &doc, NbestStorage &nbest);
+};
+
+#endif
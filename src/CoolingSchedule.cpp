@@ -25,7 +25,10 @@
 #include <limits>
 #include <numeric>
 
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
 #include <boost/lambda/lambda.hpp>
+#include <boost/serialization/vector.hpp>
 
 CoolingSchedule
 *CoolingSchedule::createCoolingSchedule(
@@ -172,3 +175,50 @@ void AartsLaarhovenSchedule::startNextChain()
 	muBuffer_.push_back(mu);
 	stepsInChain_ = 0;
 }
+
+void HillclimbingSchedule::saveCheckpoint(boost::archive::binary_oarchive &ar) const {
+	ar << rejectionCounter_;
+}
+
+void HillclimbingSchedule::loadCheckpoint(boost::archive::binary_iarchive &ar) {
+	ar >> rejectionCounter_;
+}
+
+void GeometricDecaySchedule::saveCheckpoint(boost::archive::binary_oarchive &ar) const {
+	ar << step_;
+}
+
+void GeometricDecaySchedule::loadCheckpoint(boost::archive::binary_iarchive &ar) {
+	ar >> step_;
+}
+
+void AartsLaarhovenSchedule::saveCheckpoint(boost::archive::binary_oarchive &ar) const {
+	std::vector<Float> mu(muBuffer_.begin(), muBuffer_.end());
+	ar << initSteps_;
+	ar << mu;
+	ar << mu1_;
+	ar << m1_;
+	ar << m2_;
+	ar << scoreDecrease_;
+	ar << stepsInChain_;
+	ar << lastScore_;
+	ar << chainCosts_;
+	ar << lastTemperature_;
+	ar << temperature_;
+}
+
+void AartsLaarhovenSchedule::loadCheckpoint(boost::archive::binary_iarchive &ar) {
+	std::vector<Float> mu;
+	ar >> initSteps_;
+	ar >> mu;
+	ar >> mu1_;
+	ar >> m1_;
+	ar >> m2_;
+	ar >> scoreDecrease_;
+	ar >> stepsInChain_;
+	ar >> lastScore_;
+	ar >> chainCosts_;
+	ar >> lastTemperature_;
+	ar >> temperature_;
+	muBuffer_.assign(mu.begin(), mu.end());
+}
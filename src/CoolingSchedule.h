@@ -28,6 +28,12 @@
 
 #include <boost/circular_buffer.hpp>
 
+namespace boost {
+namespace archive {
+	class binary_iarchive;
+	class binary_oarchive;
+}}
+
 class CoolingSchedule {
 public:
 	virtual ~CoolingSchedule() {}
@@ -36,6 +42,22 @@ public:
 	virtual bool isDone() const = 0;
 	virtual void step(Float score, bool accept) = 0;
 
+	// Called by searches with a time limit with the fraction of the
+	// available time used so far. Schedules that cool down over a known
+	// number of steps can compress their remaining steps into the remaining
+	// time; the others run until they are done or interrupted.
+	virtual void setTimeFraction(Float fraction) {}
+
+	// Whether step() needs the exact score of rejected steps. Computing it
+	// would defeat early rejection, so the searches only do so on request.
+	virtual bool usesRejectedScores() const {
+		return false;
+	}
+
+	// save and restore the progress of the schedule in search checkpoints
+	virtual void saveCheckpoint(boost::archive::binary_oarchive &ar) const = 0;
+	virtual void loadCheckpoint(boost::archive::binary_iarchive &ar) = 0;
+
 	static CoolingSchedule *createCoolingSchedule(const Parameters &type);
 };
 
@@ -66,6 +88,9 @@ public:
 		else
 			rejectionCounter_++;
 	}
+
+	virtual void saveCheckpoint(boost::archive::binary_oarchive &ar) const;
+	virtual void loadCheckpoint(boost::archive::binary_iarchive &ar);
 };
 
 class GeometricDecaySchedule : public CoolingSchedule {
@@ -101,6 +126,18 @@ public:
 		if(accept || !stepOnAcceptance_)
 			step_++;
 	}
+
+	// Skips ahead so that the schedule ends when the time is up.
+	virtual void setTimeFraction(
+		Float fraction
+	) {
+		Float totalSteps = (-30 - logStartTemperature_) / logDecayFactor_;
+		if(fraction * totalSteps > step_)
+			step_ = static_cast<uint>(fraction * totalSteps);
+	}
+
+	virtual void saveCheckpoint(boost::archive::binary_oarchive &ar) const;
+	virtual void loadCheckpoint(boost::archive::binary_iarchive &ar);
 };
 
 class AartsLaarhovenSchedule : public CoolingSchedule {
@@ -137,6 +174,14 @@ public:
 	virtual Float getTemperature() const;
 	virtual bool isDone() const;
 	virtual void step(Float score, bool accept);
+
+	// The initial temperature is adapted to the scores of all steps.
+	virtual bool usesRejectedScores() const {
+		return initSteps_ > 0;
+	}
+
+	virtual void saveCheckpoint(boost::archive::binary_oarchive &ar) const;
+	virtual void loadCheckpoint(boost::archive::binary_iarchive &ar);
 };
 
 #endif
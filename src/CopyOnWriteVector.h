@@ -0,0 +1,154 @@
+/*
+ *  CopyOnWriteVector.h
+ *
+ *  Copyright 2012 by Christian Hardmeier. All rights reserved.
+ *
+ *  This file is part of Docent, a document-level decoder for phrase-based
+ *  statistical machine translation.
+ *
+ *  Docent is free software: you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation, either version 3 of the License, or (at your option) any later
+ *  version.
+ *
+ *  Docent is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  Docent. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef docent_CopyOnWriteVector_h
+#define docent_CopyOnWriteVector_h
+
+#include "Docent.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+#include <boost/iterator/indirect_iterator.hpp>
+#include <boost/shared_ptr.hpp>
+
+/**
+ * A vector whose elements are shared between copies of the vector and only
+ * duplicated when one of the copies modifies them. Copying the vector costs
+ * one reference count update per element, and modifying an element costs one
+ * copy of that element at most. Read access works as with std::vector, while
+ * write access must go through modify() or swapElement().
+ *
+ * Elements are stored individually on the heap, so references to an element
+ * stay valid for as long as any copy of the vector holds on to it.
+ */
+template<class T>
+class CopyOnWriteVector {
+private:
+	typedef boost::shared_ptr<T> Pointer_;
+	typedef std::vector<Pointer_> Vector_;
+
+	Vector_ elements_;
+
+public:
+	typedef T value_type;
+	typedef const T &const_reference;
+	typedef typename Vector_::size_type size_type;
+	typedef boost::indirect_iterator<typename Vector_::const_iterator,const T> const_iterator;
+	typedef const_iterator iterator;
+
+	CopyOnWriteVector() {}
+
+	explicit CopyOnWriteVector(size_type n) {
+		resize(n);
+	}
+
+	size_type size() const {
+		return elements_.size();
+	}
+
+	bool empty() const {
+		return elements_.empty();
+	}
+
+	void reserve(size_type n) {
+		elements_.reserve(n);
+	}
+
+	void resize(size_type n) {
+		uint oldsize = elements_.size();
+		elements_.resize(n);
+		for(uint i = oldsize; i < n; i++)
+			elements_[i].reset(new T());
+	}
+
+	void push_back(const T &e) {
+		elements_.push_back(Pointer_(new T(e)));
+	}
+
+	const T &operator[](size_type i) const {
+		return *elements_[i];
+	}
+
+	const T &front() const {
+		return *elements_.front();
+	}
+
+	const T &back() const {
+		return *elements_.back();
+	}
+
+	const_iterator begin() const {
+		return const_iterator(elements_.begin());
+	}
+
+	const_iterator end() const {
+		return const_iterator(elements_.end());
+	}
+
+	// Returns a writable reference to element i, copying the element first
+	// if it is shared.
+	T &modify(size_type i) {
+		if(!elements_[i].unique())
+			elements_[i].reset(new T(*elements_[i]));
+		return *elements_[i];
+	}
+
+	// Exchanges the contents of element i with e. Unlike modify(i).swap(e),
+	// this never copies a shared element only to overwrite it.
+	void swapElement(size_type i, T &e) {
+		if(!elements_[i].unique())
+			elements_[i].reset(new T());
+		using std::swap;
+		swap(*elements_[i], e);
+	}
+
+	void swap(CopyOnWriteVector<T> &o) {
+		elements_.swap(o.elements_);
+	}
+
+	// Makes element i refer to the same object as element i of o.
+	void share(size_type i, const CopyOnWriteVector<T> &o) {
+		elements_[i] = o.elements_[i];
+	}
+
+	bool operator==(const CopyOnWriteVector<T> &o) const {
+		if(elements_.size() != o.elements_.size())
+			return false;
+		for(uint i = 0; i < elements_.size(); i++)
+			if(elements_[i] != o.elements_[i] && !(*elements_[i] == *o.elements_[i]))
+				return false;
+		return true;
+	}
+
+	bool operator!=(const CopyOnWriteVector<T> &o) const {
+		return !(*this == o);
+	}
+};
+
+template<class T>
+std::size_t hash_value(const CopyOnWriteVector<T> &v) {
+	return boost::hash_range(v.begin(), v.end());
+}
+
+#endif
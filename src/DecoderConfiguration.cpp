@@ -26,6 +26,7 @@
 #include "StateGenerator.h"
 #include "models/PhraseTable.h"
 
+#include <algorithm>
 #include <iterator>
 #include <limits>
 #include <map>
@@ -182,7 +183,7 @@ const {
 
 DecoderConfiguration::DecoderConfiguration(
 	const ConfigurationFile &file
-) : logger_("DecoderConfiguration"), random_(Random::create())
+) : logger_("DecoderConfiguration"), random_(Random::create()), phraseTableScoreIndex_(0)
 {
 	uint step = 0;
 	for(Arabica::DOM::Node<std::string>
@@ -271,7 +272,7 @@ void DecoderConfiguration::setupStateGenerator(
 		BOOST_THROW_EXCEPTION(ConfigurationException());
 	}
 
-	stateGenerator_ = new StateGenerator(type, Parameters(logger_, istateNode), random_);
+	stateGenerator_ = new StateGenerator(type, Parameters(logger_, istateNode));
 
 	for(c = n.getFirstChild(); c != 0; c = c.getNextSibling()) {
 		if(c.getNodeType() != Arabica::DOM::Node<std::string>::ELEMENT_NODE
@@ -292,6 +293,8 @@ void DecoderConfiguration::setupStateGenerator(
 			Parameters(logger_, onode)
 		);
 	}
+
+	stateGenerator_->setupOperationSelection(Parameters(logger_, n));
 }
 
 void DecoderConfiguration::setupSearch(
@@ -305,7 +308,7 @@ void DecoderConfiguration::setupSearch(
 void DecoderConfiguration::setupModels(
 	Arabica::DOM::Node<std::string> n
 ) {
-	FeatureFunctionFactory ffFactory(random_);
+	FeatureFunctionFactory ffFactory;
 	uint scoreIndex = 0;
 	std::set<std::string> ids;
 	for(Arabica::DOM::Node<std::string>
@@ -337,7 +340,8 @@ void DecoderConfiguration::setupModels(
 
 		// TODO: This is messy.
 		if(type == "phrase-table" && !phraseTable_) {
-			phraseTable_ = boost::dynamic_pointer_cast<const PhraseTable>(ff_impl);
+			phraseTable_ = boost::dynamic_pointer_cast<PhraseTable>(ff_impl);
+			phraseTableScoreIndex_ = ff->getScoreIndex();
 			assert(phraseTable_);
 		}
 	}
@@ -347,6 +351,15 @@ void DecoderConfiguration::setupModels(
 		LOG(logger_, error, "No models found.");
 		BOOST_THROW_EXCEPTION(ConfigurationException());
 	}
+
+	// models of equal cost are evaluated in the order of the configuration file
+	std::vector<std::pair<Float,uint> > costs;
+	for(uint i = 0; i < featureFunctions_.size(); i++)
+		costs.push_back(std::make_pair(featureFunctions_[i].getEvaluationCost(), i));
+	std::sort(costs.begin(), costs.end());
+	evaluationOrder_.clear();
+	for(uint i = 0; i < costs.size(); i++)
+		evaluationOrder_.push_back(costs[i].second);
 }
 
 void DecoderConfiguration::setupWeights(
@@ -416,4 +429,9 @@ void DecoderConfiguration::setupWeights(
 		LOG(logger_, error, "Insufficient number of weights: " << coveredWeights);
 		BOOST_THROW_EXCEPTION(ConfigurationException());
 	}
+
+	if(phraseTable_) {
+		std::vector<Float>::const_iterator w = featureWeights_.begin() + phraseTableScoreIndex_;
+		phraseTable_->setFilterWeights(std::vector<Float>(w, w + phraseTable_->getNumberOfScores()));
+	}
 }
@@ -81,9 +81,11 @@ private:
 	Logger logger_;
 	Random random_;
 
-	boost::shared_ptr<const PhraseTable> phraseTable_;
+	boost::shared_ptr<PhraseTable> phraseTable_;
+	uint phraseTableScoreIndex_;
 
 	FeatureFunctionList featureFunctions_;
+	std::vector<uint> evaluationOrder_;
 	std::vector<Float> featureWeights_;
 	uint nscores_;
 
@@ -112,6 +114,11 @@ public:
 		return featureFunctions_;
 	}
 
+	// Indices of the feature functions in order of increasing evaluation cost.
+	const std::vector<uint> &getFeatureEvaluationOrder() const {
+		return evaluationOrder_;
+	}
+
 	const std::vector<Float> &getFeatureWeights() const {
 		return featureWeights_;
 	}
@@ -23,6 +23,7 @@
 #include "DocumentState.h"
 
 #include "MMAXDocument.h"
+#include "ParallelFor.h"
 #include "PhrasePairCollection.h"
 #include "SearchStep.h"
 #include "StateGenerator.h"
@@ -32,6 +33,9 @@
 #include <iterator>
 
 #include <boost/foreach.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/serialization/string.hpp>
 #include <boost/lambda/lambda.hpp>
 #include <boost/lambda/bind.hpp>
 #include <boost/lambda/construct.hpp>
@@ -44,6 +48,7 @@ DocumentState::DocumentState(
 ) :	logger_("DocumentState"),
 	configuration_(&config),
 	docNumber_(docNumber),
+	random_(config.getRandom().createStream(docNumber)),
 	inputdoc_(inputdoc),
 	scores_(configuration_->getTotalNumberOfScores()),
 	generation_(0)
@@ -58,6 +63,7 @@ DocumentState::DocumentState(
 ) :	logger_("DocumentState"),
 	configuration_(&config),
 	docNumber_(docNumber),
+	random_(config.getRandom().createStream(docNumber)),
 	inputdoc_(inputdoc->asMMAXDocument()),
 	scores_(configuration_->getTotalNumberOfScores()),
 	generation_(0)
@@ -65,30 +71,148 @@ DocumentState::DocumentState(
 	init();
 }
 
+DocumentState::DocumentState(
+	const DecoderConfiguration &config,
+	const boost::shared_ptr<const MMAXDocument> &inputdoc,
+	int docNumber,
+	boost::archive::binary_iarchive &ar
+) :	logger_("DocumentState"),
+	configuration_(&config),
+	docNumber_(docNumber),
+	random_(config.getRandom().createStream(docNumber)),
+	inputdoc_(inputdoc),
+	scores_(configuration_->getTotalNumberOfScores()),
+	generation_(0)
+{
+	initInput(NULL);
+	loadCheckpoint(ar);
+}
+
+DocumentState::DocumentState(
+	const DecoderConfiguration &config,
+	const boost::shared_ptr<const NistXmlDocument> &inputdoc,
+	int docNumber,
+	boost::archive::binary_iarchive &ar
+) :	logger_("DocumentState"),
+	configuration_(&config),
+	docNumber_(docNumber),
+	random_(config.getRandom().createStream(docNumber)),
+	inputdoc_(inputdoc->asMMAXDocument()),
+	scores_(configuration_->getTotalNumberOfScores()),
+	generation_(0)
+{
+	initInput(NULL);
+	loadCheckpoint(ar);
+}
+
+namespace {
+
+// Looks up the phrase translations of a sentence and, if segmentations
+// is given, creates its initial segmentation. Each sentence draws from its
+// own random stream so the result doesn't depend on the order in which the
+// sentences are processed.
+struct SentenceInitialisation {
+	const PhraseTable &ttable;
+	const StateGenerator &generator;
+	const MMAXDocument &inputdoc;
+	uint docNumber;
+	Random random;
+	std::vector<boost::shared_ptr<const PhrasePairCollection> > &translations;
+	std::vector<PhraseSegmentation> *segmentations;
+
+	SentenceInitialisation(
+		const PhraseTable &pttable,
+		const StateGenerator &pgenerator,
+		const MMAXDocument &pinputdoc,
+		uint pdocNumber,
+		Random prandom,
+		std::vector<boost::shared_ptr<const PhrasePairCollection> > &ptranslations,
+		std::vector<PhraseSegmentation> *psegmentations
+	) :	ttable(pttable),
+		generator(pgenerator),
+		inputdoc(pinputdoc),
+		docNumber(pdocNumber),
+		random(prandom),
+		translations(ptranslations),
+		segmentations(psegmentations)
+	{}
+
+	void operator()(uint sentno) const {
+		std::vector<Word> snt(inputdoc.sentence_begin(sentno), inputdoc.sentence_end(sentno));
+		translations[sentno] = ttable.getPhrasesForSentence(snt);
+		if(segmentations)
+			(*segmentations)[sentno] = generator.initSegmentation(
+				translations[sentno],
+				snt,
+				docNumber,
+				sentno,
+				random.createStream(Random::SentenceInitialisationStream, sentno)
+			);
+	}
+};
+
+}
+
 void DocumentState::init()
 {
-	sentences_.reserve(inputdoc_->getNumberOfSentences());
-	phraseTranslations_.reserve(inputdoc_->getNumberOfSentences());
+	std::vector<PhraseSegmentation> segmentations(inputdoc_->getNumberOfSentences());
+	initInput(&segmentations);
+
+	sentences_.reserve(segmentations.size());
+	BOOST_FOREACH(const PhraseSegmentation &seg, segmentations)
+		sentences_.push_back(seg);
+	initTargetWordOffsets();
+
+	initFeatureStates();
+}
+
+// Everything that only depends on the input document, not on its translation,
+// and the initial segmentations if asked for.
+void DocumentState::initInput(std::vector<PhraseSegmentation> *initialSegmentations)
+{
+	const StateGenerator &generator = configuration_->getStateGenerator();
+
+	// The sentences are independent, so they can be initialised in parallel.
+	phraseTranslations_.resize(inputdoc_->getNumberOfSentences());
+	parallelFor(inputdoc_->getNumberOfSentences(), generator.getInitialisationThreads(),
+		SentenceInitialisation(configuration_->getPhraseTable(), generator, *inputdoc_,
+			docNumber_, random_, phraseTranslations_, initialSegmentations));
+
 	std::vector<Float> *sntlen = new std::vector<Float>();
 	sntlen->reserve(inputdoc_->getNumberOfSentences());
 	Float cumlength = Float(0);
-	const PhraseTable &ttable = configuration_->getPhraseTable();
-	const StateGenerator &generator = configuration_->getStateGenerator();
 	for(uint i = 0; i < inputdoc_->getNumberOfSentences(); i++) {
-		std::vector<Word> snt(inputdoc_->sentence_begin(i), inputdoc_->sentence_end(i));
-		phraseTranslations_.push_back(ttable.getPhrasesForSentence(snt));
-		PhraseSegmentation ps = generator.initSegmentation(
-			phraseTranslations_[i],
-			snt,
-			docNumber_,
-			i
-		);
-		sentences_.push_back(ps);
-		cumlength += snt.size();
+		cumlength += std::distance(inputdoc_->sentence_begin(i), inputdoc_->sentence_end(i));
 		sntlen->push_back(cumlength);
 	}
 	cumulativeSentenceLength_.reset(sntlen);
 
+	generator.initOperationStatistics(operationStatistics_);
+}
+
+void DocumentState::computeTargetWordOffsets(uint sentno)
+{
+	const PhraseSegmentation &seg = sentences_[sentno];
+	std::vector<uint> offsets;
+	offsets.reserve(seg.size() + 1);
+	uint n = 0;
+	offsets.push_back(n);
+	BOOST_FOREACH(const AnchoredPhrasePair &app, seg) {
+		n += app.second.get().getTargetPhrase().get().size();
+		offsets.push_back(n);
+	}
+	targetWordOffsets_.swapElement(sentno, offsets);
+}
+
+void DocumentState::initTargetWordOffsets()
+{
+	targetWordOffsets_ = TargetWordOffsetVector(sentences_.size());
+	for(uint i = 0; i < sentences_.size(); i++)
+		computeTargetWordOffsets(i);
+}
+
+void DocumentState::initFeatureStates()
+{
 	Scores::iterator scoreit = scores_.begin();
 	const DecoderConfiguration::FeatureFunctionList &ff = configuration_->getFeatureFunctions();
 	for(DecoderConfiguration::FeatureFunctionList::const_iterator it = ff.begin();
@@ -104,11 +228,14 @@ DocumentState::DocumentState(
 ) :	logger_("DocumentState"),
 	configuration_(o.configuration_),
 	docNumber_(o.docNumber_),
+	random_(o.random_),
 	inputdoc_(o.inputdoc_),
 	sentences_(o.sentences_),
+	targetWordOffsets_(o.targetWordOffsets_),
 	phraseTranslations_(o.phraseTranslations_),
 	cumulativeSentenceLength_(o.cumulativeSentenceLength_),
 	scores_(o.scores_),
+	operationStatistics_(o.operationStatistics_),
 	generation_(o.generation_)
 {
 	using namespace boost::lambda;
@@ -124,6 +251,26 @@ DocumentState::DocumentState(
 	);
 }
 
+DocumentState::DocumentState(
+	const DocumentState &o,
+	const PhraseSegmentationVector &sentences,
+	DocumentGeneration generation
+) :	logger_("DocumentState"),
+	configuration_(o.configuration_),
+	docNumber_(o.docNumber_),
+	random_(o.random_),
+	inputdoc_(o.inputdoc_),
+	sentences_(sentences),
+	phraseTranslations_(o.phraseTranslations_),
+	cumulativeSentenceLength_(o.cumulativeSentenceLength_),
+	scores_(configuration_->getTotalNumberOfScores()),
+	operationStatistics_(o.operationStatistics_),
+	generation_(generation)
+{
+	initTargetWordOffsets();
+	initFeatureStates();
+}
+
 DocumentState &DocumentState::operator=(const DocumentState &o)
 {
 	using namespace boost::lambda;
@@ -134,10 +281,13 @@ DocumentState &DocumentState::operator=(const DocumentState &o)
 	configuration_ = o.configuration_;
 	inputdoc_ = o.inputdoc_;
 	sentences_ = o.sentences_;
+	targetWordOffsets_ = o.targetWordOffsets_;
 	docNumber_ = o.docNumber_;
+	random_ = o.random_;
 	phraseTranslations_ = o.phraseTranslations_;
 	cumulativeSentenceLength_ = o.cumulativeSentenceLength_;
 	scores_ = o.scores_;
+	operationStatistics_ = o.operationStatistics_;
 	generation_ = o.generation_;
 	std::vector<FeatureFunction::State *> ffs;
 	std::transform(
@@ -184,6 +334,7 @@ Scores DocumentState::computeSentenceScores(uint i) const
 void DocumentState::registerAttemptedMove(const SearchStep *step)
 {
 	moveCount_[step->getOperation()].first++;
+	configuration_->getStateGenerator().registerAttempt(operationStatistics_, step->getOperation());
 }
 
 void DocumentState::applyModifications(SearchStep *step)
@@ -191,25 +342,29 @@ void DocumentState::applyModifications(SearchStep *step)
 	assert(&step->getDocumentState() == this && step->getDocumentGeneration() == generation_);
 
 	moveCount_[step->getOperation()].second++;
+	configuration_->getStateGenerator().registerGain(operationStatistics_,
+		step->getOperation(), step->getScore() - getScore());
 
+	// All modifications of a sentence are applied together by assembling the
+	// new sentence from the unchanged parts of the old one and the proposals.
+	// The old sentence may still be shared with other copies of this state and
+	// is left untouched.
 	std::vector<SearchStep::Modification> &mods = step->getModifications();
-	for(std::vector<SearchStep::Modification>::iterator it = mods.begin();
-		it != mods.end();
-		++it
-	) {
+	std::vector<SearchStep::Modification>::iterator it = mods.begin();
+	while(it != mods.end()) {
 		uint sentno = it->sentno;
-		PhraseSegmentation &sent = sentences_[sentno];
-		PhraseSegmentation::const_iterator c_from_it = it->from_it;
-		PhraseSegmentation::const_iterator c_to_it = it->to_it;
-		PhraseSegmentation &proposal = it->proposal;
-
-		PhraseSegmentation::iterator from_it = sent.begin();
-		std::advance(from_it, std::distance<PhraseSegmentation::const_iterator>(from_it, c_from_it));
-		PhraseSegmentation::iterator to_it = from_it;
-		std::advance(to_it, std::distance<PhraseSegmentation::const_iterator>(to_it, c_to_it));
-
-		sent.erase(from_it, to_it);
-		sent.splice(to_it, proposal);
+		const PhraseSegmentation &old = sentences_[sentno];
+		PhraseSegmentation sent;
+		sent.reserve(old.size());
+		PhraseSegmentation::const_iterator keep_it = old.begin();
+		for(; it != mods.end() && it->sentno == sentno; ++it) {
+			sent.insert(sent.end(), keep_it, it->from_it);
+			sent.insert(sent.end(), it->proposal.begin(), it->proposal.end());
+			keep_it = it->to_it;
+		}
+		sent.insert(sent.end(), keep_it, old.end());
+		sentences_.swapElement(sentno, sent);
+		computeTargetWordOffsets(sentno);
 	}
 	scores_ = step->getScores();
 
@@ -246,13 +401,17 @@ void DocumentState::dumpFeatureFunctionStates() const
 
 void DocumentState::debugSentenceCoverage(const PhraseSegmentation &seg) const
 {
-	CoverageBitmap bm(seg.front().first.size());
+	uint sentenceLength = 0;
+	BOOST_FOREACH(const AnchoredPhrasePair &app, seg)
+		sentenceLength = std::max(sentenceLength, app.first.end());
+	CoverageBitmap bm(sentenceLength);
 	BOOST_FOREACH(const AnchoredPhrasePair &app, seg) {
-		if((bm & app.first).any()) {
-			LOG(logger_, error, "OVERLAP\n" << (bm & app.first) << '\n' << *this);
+		CoverageBitmap cov = app.first.asBitmap(sentenceLength);
+		if((bm & cov).any()) {
+			LOG(logger_, error, "OVERLAP\n" << (bm & cov) << '\n' << *this);
 			abort();
 		}
-		bm |= app.first;
+		bm |= cov;
 	}
 	if(bm.count() != bm.size()) {
 		LOG(logger_, error, "INCOMPLETE COVERAGE\n" << bm << '\n' << *this);
@@ -273,3 +432,39 @@ std::ostream &operator<<(std::ostream &os, const DocumentState &doc)
 		<< " = " << doc.getScore() << '\n';
 	return os;
 }
+
+void DocumentState::saveCheckpoint(boost::archive::binary_oarchive &ar) const
+{
+	std::vector<PhraseSegmentation> sentences(sentences_.begin(), sentences_.end());
+	std::string randomState = random_.getGeneratorState();
+	ar << sentences;
+	ar << generation_;
+	ar << randomState;
+	ar << operationStatistics_;
+}
+
+void DocumentState::loadCheckpoint(boost::archive::binary_iarchive &ar)
+{
+	std::vector<PhraseSegmentation> sentences;
+	std::string randomState;
+	ar >> sentences;
+	ar >> generation_;
+	ar >> randomState;
+	ar >> operationStatistics_;
+
+	if(sentences.size() != inputdoc_->getNumberOfSentences()) {
+		LOG(logger_, error, "Checkpoint for document " << docNumber_ << " has "
+			<< sentences.size() << " sentences instead of "
+			<< inputdoc_->getNumberOfSentences() << ".");
+		BOOST_THROW_EXCEPTION(FileFormatException());
+	}
+
+	sentences_.reserve(sentences.size());
+	BOOST_FOREACH(const PhraseSegmentation &seg, sentences)
+		sentences_.push_back(seg);
+	initTargetWordOffsets();
+
+	random_.setGeneratorState(randomState);
+
+	initFeatureStates();
+}
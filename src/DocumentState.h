@@ -24,7 +24,9 @@
 #define docent_DocumentState_h
 
 #include "Docent.h"
+#include "CopyOnWriteVector.h"
 #include "FeatureFunction.h"
+#include "OperationStatistics.h"
 #include "PhrasePair.h"
 #include "PlainTextDocument.h"
 #include "Random.h"
@@ -36,6 +38,12 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/functional/hash.hpp>
 
+namespace boost {
+namespace archive {
+	class binary_iarchive;
+	class binary_oarchive;
+}}
+
 class DecoderConfiguration;
 class MMAXDocument;
 class NistXmlDocument;
@@ -45,6 +53,14 @@ class StateOperation;
 
 typedef unsigned long DocumentGeneration;
 
+// The sentences of a document. Copies of a document state share the phrase
+// segmentations of all sentences they have not modified.
+typedef CopyOnWriteVector<PhraseSegmentation> PhraseSegmentationVector;
+
+// For each sentence, the number of target words before each phrase, with the
+// sentence length as the last element.
+typedef CopyOnWriteVector<std::vector<uint> > TargetWordOffsetVector;
+
 class DocumentState {
 	friend class StateOperation;
 	friend std::ostream &operator<<(std::ostream &os, const DocumentState &doc);
@@ -59,24 +75,41 @@ private:
 	const DecoderConfiguration *configuration_;
 
 	uint docNumber_;
+	Random random_;
 
 	boost::shared_ptr<const MMAXDocument> inputdoc_;
-	std::vector<PhraseSegmentation> sentences_;
+	PhraseSegmentationVector sentences_;
+	TargetWordOffsetVector targetWordOffsets_;
 	std::vector<boost::shared_ptr<const PhrasePairCollection> > phraseTranslations_;
 	boost::shared_ptr<const std::vector<Float> > cumulativeSentenceLength_;
 	Scores scores_;
 	std::vector<FeatureFunction::State *> featureStates_;
 
 	MoveCounts moveCount_;
+	OperationStatistics operationStatistics_;
 	DocumentGeneration generation_;
 
 	void init();
+	void initInput(std::vector<PhraseSegmentation> *initialSegmentations);
+	void initFeatureStates();
+	void computeTargetWordOffsets(uint sentno);
+	void initTargetWordOffsets();
 	void debugSentenceCoverage(const PhraseSegmentation &seg) const;
+	void loadCheckpoint(boost::archive::binary_iarchive &ar);
 
 public:
 	DocumentState(const DecoderConfiguration &config, const boost::shared_ptr<const MMAXDocument> &text, int docNumber);
 	DocumentState(const DecoderConfiguration &config, const boost::shared_ptr<const NistXmlDocument> &text, int docNumber);
+	// Restores a document state saved with saveCheckpoint. Only the phrase
+	// table lookups are repeated; the translation is taken from the checkpoint.
+	DocumentState(const DecoderConfiguration &config, const boost::shared_ptr<const MMAXDocument> &text, int docNumber,
+		boost::archive::binary_iarchive &ar);
+	DocumentState(const DecoderConfiguration &config, const boost::shared_ptr<const NistXmlDocument> &text, int docNumber,
+		boost::archive::binary_iarchive &ar);
 	DocumentState(const DocumentState &o);
+	// Same document as o with different sentences. The feature function states
+	// and scores are computed from scratch.
+	DocumentState(const DocumentState &o, const PhraseSegmentationVector &sentences, DocumentGeneration generation);
 	~DocumentState();
 	DocumentState &operator=(const DocumentState &o);
 
@@ -105,6 +138,15 @@ public:
 
 	PlainTextDocument asPlainTextDocument() const;
 
+	// Random number stream of this document. Copies of a document share the stream.
+	Random getRandom() const {
+		return random_;
+	}
+
+	void setRandom(Random rnd) {
+		random_ = rnd;
+	}
+
 	uint drawSentence(Random rnd) const {
 		return rnd.drawFromCumulativeDistribution(*cumulativeSentenceLength_);
 	}
@@ -112,7 +154,7 @@ public:
 	SearchStep *proposeSearchStep() const;
 	void applyModifications(SearchStep *step);
 
-	const std::vector<PhraseSegmentation> &getPhraseSegmentations() const {
+	const PhraseSegmentationVector &getPhraseSegmentations() const {
 		return sentences_;
 	}
 
@@ -120,6 +162,21 @@ public:
 		return sentences_[sentno];
 	}
 
+	// Number of target words in sentence sentno before the phrase at it,
+	// which may be the end of the sentence.
+	uint getTargetWordOffset(uint sentno, PhraseSegmentation::const_iterator it) const {
+		return targetWordOffsets_[sentno][it - sentences_[sentno].begin()];
+	}
+
+	uint countTargetWords(uint sentno, PhraseSegmentation::const_iterator from_it,
+			PhraseSegmentation::const_iterator to_it) const {
+		return getTargetWordOffset(sentno, to_it) - getTargetWordOffset(sentno, from_it);
+	}
+
+	uint getTargetWordCount(uint sentno) const {
+		return targetWordOffsets_[sentno].back();
+	}
+
 	Scores computeSentenceScores(uint sentno) const; // debugging only!
 
 	const Scores &getScores() const {
@@ -144,7 +201,17 @@ public:
 		return moveCount_;
 	}
 
+	const OperationStatistics &getOperationStatistics() const {
+		return operationStatistics_;
+	}
+
 	void dumpFeatureFunctionStates() const;
+
+	// Checkpoints contain the translation, the generation, the random number
+	// generator state and the operation statistics. Loading a checkpoint
+	// computes the feature function states and scores from the restored
+	// translation. The move counts are not saved.
+	void saveCheckpoint(boost::archive::binary_oarchive &ar) const;
 };
 
 std::ostream &operator<<(std::ostream &os, const DocumentState &doc);
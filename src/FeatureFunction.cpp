@@ -48,7 +48,7 @@ FeatureFunctionFactory::create(
 	FeatureFunction *ff;
 
 	if(type == "phrase-table")
-		ff = new PhraseTable(params, random_);
+		ff = new PhraseTable(params);
 	else if(type == "ngram-model")
 		ff = NgramModelFactory::createNgramModel(params);
 	else if(type == "geometric-distortion-model")
@@ -25,6 +25,7 @@
 
 #include "Docent.h"
 #include "DecoderConfiguration.h"
+#include "PooledObject.h"
 
 #include <boost/shared_ptr.hpp>
 
@@ -46,7 +47,8 @@ public:
 		virtual ~State() {}
 	};
 
-	class StateModifications {
+	// Allocated and discarded for almost every search step, so they are pooled.
+	class StateModifications : public PooledObject {
 	protected:
 		StateModifications() {}
 		StateModifications(const StateModifications &o) {}
@@ -83,6 +85,16 @@ public:
 
 	virtual uint getNumberOfScores() const = 0;
 
+	// Rough relative cost of scoring a search step with this model. After
+	// all models have estimated their scores, the exact scores are computed
+	// in order of increasing cost, and a step is rejected as soon as it fails
+	// the acceptance test with the exact scores computed so far and the
+	// estimates of the remaining models. This is only correct if the
+	// weighted estimate of a model is never lower than its exact score.
+	virtual Float getEvaluationCost() const {
+		return 1;
+	}
+
 	virtual FeatureFunction::State
 	*applyStateModifications(
 		FeatureFunction::State *oldState,
@@ -174,6 +186,10 @@ public:
 		return impl_->getNumberOfScores();
 	}
 
+	Float getEvaluationCost() const {
+		return impl_->getEvaluationCost();
+	}
+
 	FeatureFunction::State
 	*applyStateModifications(
 		FeatureFunction::State *oldState,
@@ -191,12 +207,7 @@ public:
 };
 
 class FeatureFunctionFactory {
-private:
-	Random random_;
-
 public:
-	FeatureFunctionFactory(Random rnd) : random_(rnd) {}
-
 	boost::shared_ptr<FeatureFunction>
 	create(
 		const std::string &type,
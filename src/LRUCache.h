@@ -0,0 +1,96 @@
+/*
+ *  LRUCache.h
+ *
+ *  Copyright 2012 by Christian Hardmeier. All rights reserved.
+ *
+ *  This file is part of Docent, a document-level decoder for phrase-based
+ *  statistical machine translation.
+ *
+ *  Docent is free software: you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation, either version 3 of the License, or (at your option) any later
+ *  version.
+ *
+ *  Docent is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  Docent. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef docent_LRUCache_h
+#define docent_LRUCache_h
+
+#include "Docent.h"
+
+#include <list>
+#include <utility>
+
+#include <boost/functional/hash.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
+
+/**
+ * A map holding at most maxSize entries. When a new entry doesn't fit, the
+ * entry that was least recently found or inserted is dropped. All operations
+ * are protected by a mutex, so the cache can be shared between threads.
+ * A cache of size 0 stores nothing.
+ */
+template<class Key, class Value, class Hash = boost::hash<Key> >
+class LRUCache : private boost::noncopyable {
+private:
+	typedef std::list<std::pair<Key,Value> > EntryList_;
+	typedef boost::unordered_map<Key,typename EntryList_::iterator,Hash> EntryMap_;
+
+	uint maxSize_;
+	EntryList_ entries_; // most recently used first
+	EntryMap_ index_;
+	boost::mutex mutex_;
+
+public:
+	LRUCache(uint maxSize) : maxSize_(maxSize) {}
+
+	uint getMaxSize() const {
+		return maxSize_;
+	}
+
+	// Copies the value stored for key to value and returns true if there is one.
+	bool find(const Key &key, Value &value) {
+		if(maxSize_ == 0)
+			return false;
+
+		boost::mutex::scoped_lock lock(mutex_);
+		typename EntryMap_::const_iterator it = index_.find(key);
+		if(it == index_.end())
+			return false;
+		entries_.splice(entries_.begin(), entries_, it->second);
+		value = it->second->second;
+		return true;
+	}
+
+	void insert(const Key &key, const Value &value) {
+		if(maxSize_ == 0)
+			return;
+
+		boost::mutex::scoped_lock lock(mutex_);
+		typename EntryMap_::iterator it = index_.find(key);
+		if(it != index_.end()) {
+			// another thread got there first
+			entries_.splice(entries_.begin(), entries_, it->second);
+			return;
+		}
+
+		if(index_.size() >= maxSize_) {
+			index_.erase(entries_.back().first);
+			entries_.pop_back();
+		}
+
+		entries_.push_front(std::make_pair(key, value));
+		index_.insert(std::make_pair(key, entries_.begin()));
+	}
+};
+
+#endif
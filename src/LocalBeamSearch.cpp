@@ -39,16 +39,20 @@ struct LocalBeamSearchState
 :	public SearchState
 {
 	NbestStorage beam;
+	Random random;
 	uint rejected;
 	uint nsteps;
+	Float searchTime;
 	bool aborted;
 
 	LocalBeamSearchState(
 		boost::shared_ptr<DocumentState> doc,
 		uint beamSize
 	) :	beam(beamSize),
+		random(doc->getRandom()),
 		rejected(0),
 		nsteps(0),
+		searchTime(0),
 		aborted(false)
 	{
 		beam.offer(doc);
@@ -57,14 +61,18 @@ struct LocalBeamSearchState
 	const boost::shared_ptr<DocumentState>& getLastDocumentState() {
 		return beam.getBestDocumentState();
 	}
+
+	uint getNumberOfSteps() const {
+		return nsteps;
+	}
 };
 
 LocalBeamSearch::LocalBeamSearch(
 	const DecoderConfiguration &config,
 	const Parameters &params
 ) :	logger_("LocalBeamSearch"),
-	random_(config.getRandom()),
-	generator_(config.getStateGenerator())
+	generator_(config.getStateGenerator()),
+	timeLimit_(params)
 {
 	totalMaxSteps_ = params.get<uint>("max-steps");
 	maxRejected_ = params.get<uint>("max-rejected");
@@ -91,6 +99,9 @@ void LocalBeamSearch::search(
 		bind(&NbestStorage::offer, &nbest, _1)
 	);
 
+	TimeLimit::TimePoint start = TimeLimit::now();
+	bool timeUp = false;
+
 	uint accepted = 0;
 	uint i = 0;
 	while(
@@ -101,29 +112,32 @@ void LocalBeamSearch::search(
 		&& accepted < maxAccepted
 		&& nbest.getBestScore() < targetScore_
 	) {
+		if(timeLimit_.isLimited() && i % TimeLimit::checkInterval == 0) {
+			TimeLimit::TimePoint now = TimeLimit::now();
+			Float used = state.searchTime + TimeLimit::secondsBetween(start, now);
+			if(timeLimit_.getRemainingTime(used, now) <= 0) {
+				timeUp = true;
+				break;
+			}
+		}
+
 		AcceptanceDecision accept(state.beam.getLowestScore());
-		boost::shared_ptr<DocumentState> doc = state.beam.pickRandom(random_);
+		boost::shared_ptr<DocumentState> doc = state.beam.pickRandom(state.random);
 		SearchStep *step = generator_.createSearchStep(*doc);
 		if(step == NULL) {
 			state.aborted = true;
 			break;
 		}
 		doc->registerAttemptedMove(step);
-		if(step->isProvisionallyAcceptable(accept)) {
-			if(accept(step->getScore())) {
-				LOG(logger_, debug, "Accepting.");
-				boost::shared_ptr<DocumentState> clone =
-					boost::make_shared<DocumentState>(*doc);
-				doc->applyModifications(step);
-				LOG(logger_, debug, *doc);
-				state.beam.offer(doc);
-				nbest.offer(doc);
-				accepted++;
-			} else {
-				LOG(logger_, debug, "Discarding.");
-				state.rejected++;
-				delete step;
-			}
+		if(step->isAcceptable(accept)) {
+			LOG(logger_, debug, "Accepting.");
+			boost::shared_ptr<DocumentState> clone =
+				boost::make_shared<DocumentState>(*doc);
+			doc->applyModifications(step);
+			LOG(logger_, debug, *doc);
+			state.beam.offer(doc);
+			nbest.offer(doc);
+			accepted++;
 		} else {
 			LOG(logger_, debug, "Discarding.");
 			state.rejected++;
@@ -133,6 +147,11 @@ void LocalBeamSearch::search(
 		state.nsteps++;
 	}
 
+	state.searchTime += TimeLimit::secondsBetween(start, TimeLimit::now());
+
+	if(timeUp)
+		LOG(logger_, normal, "Time limit reached after " << state.searchTime << " seconds.");
+
 	if(state.rejected >= maxRejected_)
 		LOG(logger_, normal, "Maximum number of rejections (" << maxRejected_ << ") reached.");
 
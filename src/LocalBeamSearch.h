@@ -25,17 +25,16 @@
 
 #include "Docent.h"
 #include "SearchAlgorithm.h"
+#include "TimeLimit.h"
 
 class DecoderConfiguration;
 class DocumentState;
 class NbestStorage;
-class Random;
 class StateGenerator;
 
 class LocalBeamSearch : public SearchAlgorithm {
 private:
 	Logger logger_;
-	Random random_;
 	const StateGenerator &generator_;
 	uint totalMaxSteps_;
 	Float targetScore_;
@@ -43,11 +42,21 @@ private:
 	uint maxRejected_;
 	uint beamSize_;
 
+	TimeLimit timeLimit_;
+
 public:
 	LocalBeamSearch(const DecoderConfiguration &config, const Parameters &params);
 
 	virtual SearchState *createState(boost::shared_ptr<DocumentState> doc) const;
 	virtual void search(SearchState *sstate, NbestStorage &nbest, uint maxSteps, uint maxAccepted) const;
+
+	virtual void setJobSize(uint documents, uint concurrency) const {
+		timeLimit_.setJobSize(documents, concurrency);
+	}
+
+	virtual void finishDocument() const {
+		timeLimit_.finishDocument();
+	}
 };
 
 #endif
@@ -23,25 +23,39 @@
 #include "Logger.h"
 
 Logger::IndexMap_ Logger::indices_;
-std::vector<LogLevel> Logger::levels_;
+std::deque<LogLevel> Logger::levels_;
+boost::mutex Logger::mutex_;
+boost::thread_specific_ptr<Logger::IndexMap_> Logger::threadIndices_;
 
-uint Logger::findChannel(const std::string &channel) {
-	uint idx;
+LogLevel &Logger::findChannel(const std::string &channel) {
+	IndexMap_ *threadIndices = threadIndices_.get();
+	if(threadIndices == NULL) {
+		threadIndices = new IndexMap_();
+		threadIndices_.reset(threadIndices);
+	} else {
+		IndexMap_::const_iterator it = threadIndices->find(channel);
+		if(it != threadIndices->end())
+			return *it->second;
+	}
+
+	boost::mutex::scoped_lock lock(mutex_);
+
+	LogLevel *level;
 
 	IndexMap_::const_iterator it = indices_.find(channel);
 	if(it == indices_.end()) {
-		idx = levels_.size();
 		levels_.push_back(normal);
-		indices_.insert(std::make_pair(channel, idx));
+		level = &levels_.back();
+		indices_.insert(std::make_pair(channel, level));
 	} else
-		idx = it->second;
+		level = it->second;
 
-	return idx;
+	threadIndices->insert(std::make_pair(channel, level));
+	return *level;
 }
 
-Logger::Logger(const std::string &channel) : index_(findChannel(channel)) {}
+Logger::Logger(const std::string &channel) : level_(&findChannel(channel)) {}
 
 void Logger::setLogLevel(const std::string &channel, LogLevel level) {
-	uint idx = findChannel(channel);
-	levels_[idx] = level;
+	findChannel(channel) = level;
 }
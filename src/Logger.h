@@ -25,9 +25,12 @@
 
 #include "Docent.h"
 
+#include <deque>
 #include <iostream>
-#include <vector>
+#include <sstream>
 
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
 #include <boost/unordered_map.hpp>
 
 enum LogLevel {
@@ -39,13 +42,19 @@ enum LogLevel {
 
 class Logger {
 private:
-	typedef boost::unordered_map<std::string,uint> IndexMap_;
+	typedef boost::unordered_map<std::string,LogLevel *> IndexMap_;
 	static IndexMap_ indices_;
-	static std::vector<LogLevel> levels_;
+	// A deque never moves its elements when it grows, so loggers can keep
+	// a pointer to their level while other threads register new channels.
+	static std::deque<LogLevel> levels_;
+	static boost::mutex mutex_;
+	// Loggers are created for every search step, so each thread keeps its own
+	// copy of the channel index to avoid taking the lock in the common case.
+	static boost::thread_specific_ptr<IndexMap_> threadIndices_;
 
-	uint index_;
+	const LogLevel *level_;
 
-	static uint findChannel(const std::string &channel);
+	static LogLevel &findChannel(const std::string &channel);
 
 public:
 	static void setLogLevel(const std::string &channel, LogLevel level);
@@ -53,7 +62,7 @@ public:
 	Logger(const std::string &channel);
 
 	bool loggable(LogLevel l) const {
-		return l >= levels_[index_];
+		return l >= *level_;
 	}
 
 	std::ostream &getLogStream() const {
@@ -62,9 +71,12 @@ public:
 };
 
 // beware of double evaluation in the following macro
+// The message is formatted into a buffer first so that lines logged by
+// different threads don't get interleaved.
 #define LOG(logger, level, message) \
 	for(bool flagInLoggerMacro = (logger).loggable(level); flagInLoggerMacro; flagInLoggerMacro = false) \
-		(logger).getLogStream() << message << '\n'
+		(logger).getLogStream() << static_cast<std::ostringstream &>( \
+			std::ostringstream().flush() << message << '\n').str()
 
 // LOG_DEBUGBUILD can be used (sparingly) in places where even the loggability
 // check hurts performance noticeably.
@@ -25,9 +25,14 @@
 #include <algorithm>
 #include <limits>
 
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/foreach.hpp>
 #include <boost/lambda/lambda.hpp>
 #include <boost/lambda/bind.hpp>
 #include <boost/lambda/construct.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/serialization/vector.hpp>
 #include <boost/shared_ptr.hpp>
 
 NbestStorage::NbestStorage(uint size)
@@ -69,3 +74,35 @@ void NbestStorage::copyNbestList(std::vector<boost::shared_ptr<const DocumentSta
 	std::copy(nbest_.begin(), nbest_.end(), outvec.begin());
 	std::sort_heap(outvec.begin(), outvec.end(), compareScores);
 }
+
+void NbestStorage::saveCheckpoint(boost::archive::binary_oarchive &ar) const {
+	uint n = nbest_.size();
+	ar << n;
+	BOOST_FOREACH(const boost::shared_ptr<DocumentState> &doc, nbest_) {
+		const PhraseSegmentationVector &segs = doc->getPhraseSegmentations();
+		std::vector<PhraseSegmentation> sentences(segs.begin(), segs.end());
+		DocumentGeneration generation = doc->getGeneration();
+		ar << sentences;
+		ar << generation;
+	}
+}
+
+void NbestStorage::loadCheckpoint(boost::archive::binary_iarchive &ar, const DocumentState &templ) {
+	nbest_.clear();
+	nbestHash_.clear();
+	bestScore_ = -std::numeric_limits<Float>::infinity();
+
+	uint n;
+	ar >> n;
+	for(uint i = 0; i < n; i++) {
+		std::vector<PhraseSegmentation> sentences;
+		DocumentGeneration generation;
+		ar >> sentences;
+		ar >> generation;
+		PhraseSegmentationVector segs;
+		segs.reserve(sentences.size());
+		BOOST_FOREACH(const PhraseSegmentation &seg, sentences)
+			segs.push_back(seg);
+		offer(boost::make_shared<DocumentState>(templ, segs, generation));
+	}
+}
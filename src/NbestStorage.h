@@ -33,6 +33,12 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/unordered_set.hpp>
 
+namespace boost {
+namespace archive {
+	class binary_iarchive;
+	class binary_oarchive;
+}}
+
 class NbestStorage {
 private:
 	template<class T>
@@ -56,7 +62,16 @@ public:
 
 	bool offer(const boost::shared_ptr<const DocumentState> &doc);
 	void copyNbestList(std::vector<boost::shared_ptr<const DocumentState> > &outvec) const;
+
+	// The stored documents are restored as copies of templ with the saved
+	// translations.
+	void saveCheckpoint(boost::archive::binary_oarchive &ar) const;
+	void loadCheckpoint(boost::archive::binary_iarchive &ar, const DocumentState &templ);
 	
+	uint getMaxSize() const {
+		return maxSize_;
+	}
+
 	Float getBestScore() const {
 		return bestScore_;
 	}
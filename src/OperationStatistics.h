@@ -0,0 +1,53 @@
+/*
+ *  OperationStatistics.h
+ *
+ *  Copyright 2012 by Christian Hardmeier. All rights reserved.
+ *
+ *  This file is part of Docent, a document-level decoder for phrase-based
+ *  statistical machine translation.
+ *
+ *  Docent is free software: you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation, either version 3 of the License, or (at your option) any later
+ *  version.
+ *
+ *  Docent is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  Docent. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef docent_OperationStatistics_h
+#define docent_OperationStatistics_h
+
+#include "Docent.h"
+
+#include <vector>
+
+/**
+ * Recent performance of the state operations on one document, used by the
+ * StateGenerator to adapt the probabilities of the operations during search
+ * if adaptive operation selection is enabled. The vectors are indexed like
+ * the operations of the StateGenerator.
+ */
+struct OperationStatistics {
+	std::vector<Float> attempts;
+	std::vector<Float> gains;
+	std::vector<Float> cumulativeDistribution;
+	uint stepsSinceUpdate;
+
+	OperationStatistics() : stepsSinceUpdate(0) {}
+
+	template<class Archive>
+	void serialize(Archive &ar, const unsigned int version) {
+		ar & attempts;
+		ar & gains;
+		ar & cumulativeDistribution;
+		ar & stepsSinceUpdate;
+	}
+};
+
+#endif
@@ -0,0 +1,98 @@
+/*
+ *  ParallelFor.h
+ *
+ *  Copyright 2012 by Christian Hardmeier. All rights reserved.
+ *
+ *  This file is part of Docent, a document-level decoder for phrase-based
+ *  statistical machine translation.
+ *
+ *  Docent is free software: you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation, either version 3 of the License, or (at your option) any later
+ *  version.
+ *
+ *  Docent is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  Docent. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef docent_ParallelFor_h
+#define docent_ParallelFor_h
+
+#include "Docent.h"
+
+#include <algorithm>
+
+#include <boost/exception_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+/**
+ * Calls f(i) for i = 0, ..., n-1 on up to nthreads threads and waits for all
+ * calls to complete. Indices are handed out in increasing order to whichever
+ * thread is idle. If a call throws an exception, no further indices are handed
+ * out and the first exception is rethrown in the calling thread.
+ * With nthreads == 1, everything runs in the calling thread.
+ */
+template<class Function>
+class ParallelFor {
+private:
+	Function f_;
+	uint n_;
+	uint next_;
+	boost::mutex mutex_;
+	boost::exception_ptr error_;
+
+	void work() {
+		for(;;) {
+			uint i;
+			{
+				boost::mutex::scoped_lock lock(mutex_);
+				if(error_ || next_ >= n_)
+					return;
+				i = next_++;
+			}
+
+			try {
+				f_(i);
+			} catch(...) {
+				boost::mutex::scoped_lock lock(mutex_);
+				if(!error_)
+					error_ = boost::current_exception();
+				return;
+			}
+		}
+	}
+
+public:
+	ParallelFor(uint n, Function f) : f_(f), n_(n), next_(0) {}
+
+	void run(uint nthreads) {
+		nthreads = std::min(nthreads, n_);
+		if(nthreads <= 1) {
+			for(uint i = 0; i < n_; i++)
+				f_(i);
+			return;
+		}
+
+		boost::thread_group workers;
+		for(uint i = 0; i < nthreads; i++)
+			workers.add_thread(new boost::thread(&ParallelFor::work, this));
+		workers.join_all();
+
+		if(error_)
+			boost::rethrow_exception(error_);
+	}
+};
+
+template<class Function>
+void parallelFor(uint n, uint nthreads, Function f) {
+	ParallelFor<Function> pf(n, f);
+	pf.run(nthreads);
+}
+
+#endif
@@ -0,0 +1,277 @@
+/*
+ *  ParallelTempering.cpp
+ *
+ *  Copyright 2012 by Christian Hardmeier. All rights reserved.
+ *
+ *  This file is part of Docent, a document-level decoder for phrase-based
+ *  statistical machine translation.
+ *
+ *  Docent is free software: you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation, either version 3 of the License, or (at your option) any later
+ *  version.
+ *
+ *  Docent is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  Docent. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ParallelTempering.h"
+
+#include "NbestStorage.h"
+#include "ParallelFor.h"
+#include "Random.h"
+#include "SearchStep.h"
+#include "StateGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
+struct ParallelTemperingSearchState
+:	public SearchState
+{
+	struct Replica {
+		boost::shared_ptr<DocumentState> document;
+		uint accepted;
+		bool aborted;
+
+		Replica(boost::shared_ptr<DocumentState> doc) :
+			document(doc), accepted(0), aborted(false) {}
+	};
+
+	boost::shared_ptr<DocumentState> document;
+	Random random;
+	std::vector<Replica> replicas;
+	// ladder[k] is the index of the replica currently at temperature k
+	std::vector<uint> ladder;
+	// (attempted, accepted) exchanges between temperatures k and k+1
+	std::vector<std::pair<uint,uint> > exchanges;
+	uint nsteps;
+	uint nrounds;
+	bool aborted;
+
+	ParallelTemperingSearchState(
+		boost::shared_ptr<DocumentState> doc,
+		uint nreplicas
+	) :	document(doc),
+		random(doc->getRandom()),
+		exchanges(nreplicas - 1, std::make_pair(0u, 0u)),
+		nsteps(0),
+		nrounds(0),
+		aborted(false)
+	{
+		replicas.reserve(nreplicas);
+		ladder.reserve(nreplicas);
+		for(uint i = 0; i < nreplicas; i++) {
+			boost::shared_ptr<DocumentState> replica = boost::make_shared<DocumentState>(*doc);
+			replica->setRandom(doc->getRandom().createStream(Random::ReplicaStream, i));
+			replicas.push_back(Replica(replica));
+			ladder.push_back(i);
+		}
+	}
+
+	const boost::shared_ptr<DocumentState>& getLastDocumentState() {
+		return document;
+	}
+
+	uint getNumberOfSteps() const {
+		return nsteps;
+	}
+};
+
+ParallelTempering::ParallelTempering(
+	const DecoderConfiguration &config,
+	const Parameters &params
+) :	logger_("ParallelTempering"),
+	generator_(config.getStateGenerator())
+{
+	totalMaxSteps_ = params.get<uint>("max-steps");
+	targetScore_ = params.get<Float>("target-score", std::numeric_limits<Float>::infinity());
+	swapInterval_ = params.get<uint>("swap-interval", 100);
+
+	uint nreplicas = params.get<uint>("replicas");
+	Float minTemperature = params.get<Float>("min-temperature");
+	Float maxTemperature = params.get<Float>("max-temperature");
+	nthreads_ = params.get<uint>("threads", nreplicas);
+
+	if(nreplicas == 0 || swapInterval_ == 0 || nthreads_ == 0) {
+		LOG(logger_, error, "replicas, swap-interval and threads must be positive.");
+		BOOST_THROW_EXCEPTION(ConfigurationException());
+	}
+
+	if(minTemperature <= 0 || maxTemperature < minTemperature) {
+		LOG(logger_, error, "Temperatures must satisfy 0 < min-temperature <= max-temperature.");
+		BOOST_THROW_EXCEPTION(ConfigurationException());
+	}
+
+	// geometric temperature ladder, coldest first
+	temperatures_.reserve(nreplicas);
+	for(uint i = 0; i < nreplicas; i++) {
+		Float t = (nreplicas == 1) ? Float(0) : Float(i) / (nreplicas - 1);
+		temperatures_.push_back(minTemperature * std::pow(maxTemperature / minTemperature, t));
+		LOG(logger_, verbose, "Temperature of replica " << i << ": " << temperatures_.back());
+	}
+}
+
+SearchState *ParallelTempering::createState(boost::shared_ptr<DocumentState> doc) const {
+	return new ParallelTemperingSearchState(doc, temperatures_.size());
+}
+
+void ParallelTempering::search(
+	SearchState *sstate,
+	NbestStorage &nbest,
+	uint maxSteps,
+	uint maxAccepted
+) const {
+	typedef ParallelTemperingSearchState::Replica Replica;
+
+	ParallelTemperingSearchState
+		&state = dynamic_cast<ParallelTemperingSearchState &>(*sstate);
+
+	BOOST_FOREACH(const Replica &r, state.replicas)
+		nbest.offer(r.document);
+
+	// Steps are counted per replica, i.e. one step means one step of every replica.
+	uint accepted = 0;
+	uint i = 0;
+	while(
+		!state.aborted
+		&& i < maxSteps
+		&& state.nsteps < totalMaxSteps_
+		&& accepted < maxAccepted
+		&& nbest.getBestScore() < targetScore_
+	) {
+		uint nsteps = std::min(swapInterval_, std::min(maxSteps - i, totalMaxSteps_ - state.nsteps));
+
+		// NbestStorage isn't thread-safe, so each replica collects its own n-best list.
+		boost::ptr_vector<NbestStorage> replicaNbest;
+		for(uint k = 0; k < state.replicas.size(); k++)
+			replicaNbest.push_back(new NbestStorage(nbest.getMaxSize()));
+
+		parallelFor(state.replicas.size(), nthreads_, boost::bind(
+			&ParallelTempering::runReplica, this,
+			boost::ref(state), _1, nsteps, boost::ref(replicaNbest)));
+
+		for(uint k = 0; k < state.replicas.size(); k++) {
+			const Replica &r = state.replicas[state.ladder[k]];
+			accepted += r.accepted;
+			if(r.aborted)
+				state.aborted = true;
+			std::for_each(replicaNbest[k].begin(), replicaNbest[k].end(),
+				boost::bind(&NbestStorage::offer, &nbest, _1));
+		}
+
+		i += nsteps;
+		state.nsteps += nsteps;
+
+		exchangeReplicas(state);
+	}
+
+	// The assignment copies the generator of the replica, but the document
+	// must keep its own stream for later searches and checkpoints.
+	*state.document = *state.replicas[state.ladder[0]].document;
+	state.document->setRandom(state.random);
+
+	if(state.aborted)
+		LOG(logger_, normal, "Document search aborted.");
+
+	if(accepted >= maxAccepted)
+		LOG(logger_, normal, "Maximum number of accepted steps (" << maxAccepted << ") reached.");
+
+	if(i >= maxSteps)
+		LOG(logger_, normal, "Interrupting search.");
+
+	if(state.nsteps >= totalMaxSteps_)
+		LOG(logger_, normal, "Maximum number of steps (" << totalMaxSteps_ << ") reached.");
+
+	if(nbest.getBestScore() > targetScore_)
+		LOG(logger_, normal, "Found solution with better than target score.");
+
+	for(uint k = 0; k < state.exchanges.size(); k++)
+		LOG(logger_, normal,
+			   state.exchanges[k].first << '\t'
+			<< state.exchanges[k].second << '\t'
+			<< "Exchange(T=" << temperatures_[k] << ",T=" << temperatures_[k + 1] << ')'
+		);
+
+	DocumentState::MoveCounts moves;
+	BOOST_FOREACH(const Replica &r, state.replicas) {
+		const DocumentState::MoveCounts &rmoves = r.document->getMoveCounts();
+		for(DocumentState::MoveCounts::const_iterator it = rmoves.begin(); it != rmoves.end(); ++it) {
+			moves[it->first].first += it->second.first;
+			moves[it->first].second += it->second.second;
+		}
+	}
+	for(DocumentState::MoveCounts::const_iterator it = moves.begin(); it != moves.end(); ++it)
+		LOG(logger_, normal,
+			   it->second.first << '\t'
+			<< it->second.second << '\t'
+			<< it->first->getDescription()
+		);
+}
+
+void ParallelTempering::runReplica(
+	ParallelTemperingSearchState &state,
+	uint position,
+	uint nsteps,
+	boost::ptr_vector<NbestStorage> &nbest
+) const {
+	ParallelTemperingSearchState::Replica &replica = state.replicas[state.ladder[position]];
+	DocumentState &doc = *replica.document;
+	Random rnd = doc.getRandom();
+	Float temperature = temperatures_[position];
+
+	replica.accepted = 0;
+	for(uint i = 0; i < nsteps; i++) {
+		AcceptanceDecision accept(rnd, temperature, doc.getScore());
+		SearchStep *step = generator_.createSearchStep(doc);
+		if(step == NULL) {
+			replica.aborted = true;
+			break;
+		}
+		doc.registerAttemptedMove(step);
+		if(step->isAcceptable(accept)) {
+			LOG(logger_, debug, "Accepting.");
+			doc.applyModifications(step);
+			nbest[position].offer(replica.document);
+			replica.accepted++;
+		} else {
+			LOG(logger_, debug, "Discarding.");
+			delete step;
+		}
+	}
+}
+
+void ParallelTempering::exchangeReplicas(ParallelTemperingSearchState &state) const {
+	// Alternate between exchanges of the pairs (0,1), (2,3), ... and (1,2), (3,4), ...
+	for(uint k = state.nrounds % 2; k + 1 < temperatures_.size(); k += 2) {
+		const DocumentState &cold = *state.replicas[state.ladder[k]].document;
+		const DocumentState &hot = *state.replicas[state.ladder[k + 1]].document;
+
+		// The exchange is accepted with probability
+		// exp((1/T_cold - 1/T_hot) * (score_hot - score_cold)), which is what
+		// AcceptanceDecision computes for temperature 1 and an old score of 0.
+		Float delta = (1 / temperatures_[k] - 1 / temperatures_[k + 1]) *
+			(hot.getScore() - cold.getScore());
+		AcceptanceDecision accept(state.random, Float(1), Float(0));
+
+		state.exchanges[k].first++;
+		if(accept(delta)) {
+			LOG(logger_, debug, "Exchanging replicas at temperatures "
+				<< temperatures_[k] << " and " << temperatures_[k + 1] << '.');
+			std::swap(state.ladder[k], state.ladder[k + 1]);
+			state.exchanges[k].second++;
+		}
+	}
+	state.nrounds++;
+}
@@ -0,0 +1,70 @@
+/*
+ *  ParallelTempering.h
+ *
+ *  Copyright 2012 by Christian Hardmeier. All rights reserved.
+ *
+ *  This file is part of Docent, a document-level decoder for phrase-based
+ *  statistical machine translation.
+ *
+ *  Docent is free software: you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation, either version 3 of the License, or (at your option) any later
+ *  version.
+ *
+ *  Docent is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  Docent. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef docent_ParallelTempering_h
+#define docent_ParallelTempering_h
+
+#include "Docent.h"
+#include "DecoderConfiguration.h"
+#include "SearchAlgorithm.h"
+
+#include <vector>
+
+#include <boost/ptr_container/ptr_vector.hpp>
+
+class DocumentState;
+class NbestStorage;
+struct ParallelTemperingSearchState;
+
+/**
+ * Replica exchange search. A number of copies (replicas) of the document are
+ * sampled at a fixed ladder of temperatures, each in a thread of its own.
+ * After a fixed number of steps, replicas at neighbouring temperatures
+ * exchange their states with the Metropolis acceptance probability.
+ */
+class ParallelTempering : public SearchAlgorithm {
+private:
+	Logger logger_;
+	const StateGenerator &generator_;
+	uint totalMaxSteps_;
+	Float targetScore_;
+	uint swapInterval_;
+	uint nthreads_;
+	std::vector<Float> temperatures_;
+
+	void runReplica(
+		ParallelTemperingSearchState &state,
+		uint position,
+		uint nsteps,
+		boost::ptr_vector<NbestStorage> &nbest
+	) const;
+
+	void exchangeReplicas(ParallelTemperingSearchState &state) const;
+
+public:
+	ParallelTempering(const DecoderConfiguration &config, const Parameters &params);
+
+	virtual SearchState *createState(boost::shared_ptr<DocumentState> doc) const;
+	virtual void search(SearchState *sstate, NbestStorage &nbest, uint maxSteps, uint maxAccepted) const;
+};
+
+#endif
@@ -41,35 +41,35 @@ std::ostream &operator<<(std::ostream &os, const std::vector<Word> &phrase)
 	return os;
 }
 
-std::ostream &operator<<(std::ostream &os, const PhraseSegmentation &seg)
-{
-	std::copy(seg.begin(), seg.end(), std::ostream_iterator<AnchoredPhrasePair>(os, "\t"));
-	return os;
-}
-
-std::string getIndices(CoverageBitmap bitmap)
+static std::string getIndices(const SourceSpan &span, uint sentenceLength)
 {
 	std::ostringstream os;
 
-	CoverageBitmap::size_type i = bitmap.find_first();
-	CoverageBitmap::size_type prev;
-
-	os << i;
-	prev= i;
-	i = bitmap.find_next(i);
-	while (i != CoverageBitmap::npos) {
-		os << "-" <<  i;
-		prev = i;
-		i = bitmap.find_next(i);
-	}
-	os << ": " << bitmap.size();
+	os << span.start;
+	for(uint i = span.start + 1; i < span.end(); i++)
+		os << "-" << i;
+	os << ": " << sentenceLength;
 	return os.str();
 }
 
-std::ostream &operator<<(std::ostream &os, const AnchoredPhrasePair &ppair) {
+static void printAnchoredPhrasePair(std::ostream &os, const AnchoredPhrasePair &ppair, uint sentenceLength)
+{
 	os	<< ppair.second.get().getSourcePhrase().get() << "\\"
 		<< ppair.second.get().getTargetPhrase().get() << "\\"
-		<< getIndices(ppair.first);
+		<< getIndices(ppair.first, sentenceLength);
+}
+
+std::ostream &operator<<(std::ostream &os, const PhraseSegmentation &seg)
+{
+	uint sentenceLength = getSentenceLength(seg);
+	BOOST_FOREACH(const AnchoredPhrasePair &ppair, seg) {
+		printAnchoredPhrasePair(os, ppair, sentenceLength);
+		os << '\t';
+	}
 	return os;
 }
 
+std::ostream &operator<<(std::ostream &os, const AnchoredPhrasePair &ppair) {
+	printAnchoredPhrasePair(os, ppair, ppair.first.end());
+	return os;
+}
@@ -41,18 +41,26 @@ std::ostream &operator<<(std::ostream &os, const std::vector<Word> &phrase)
 	return os;
 }
 
+// The coverage is printed as a bitmap over the whole sentence, last word first.
+static void printAnchoredPhrasePair(std::ostream &os, const AnchoredPhrasePair &ppair, uint sentenceLength)
+{
+	os	<< ppair.first.asBitmap(sentenceLength) << "\t["
+		<< ppair.second.get().getSourcePhrase().get() << "] -\t["
+		<< ppair.second.get().getTargetPhrase().get() << ']';
+}
+
 std::ostream &operator<<(std::ostream &os, const PhraseSegmentation &seg)
 {
-	std::copy(seg.begin(), seg.end(),
-		std::ostream_iterator<AnchoredPhrasePair>(os, "\n")
-	);
+	uint sentenceLength = getSentenceLength(seg);
+	BOOST_FOREACH(const AnchoredPhrasePair &ppair, seg) {
+		printAnchoredPhrasePair(os, ppair, sentenceLength);
+		os << '\n';
+	}
 	return os;
 }
 
 std::ostream &operator<<(std::ostream &os, const AnchoredPhrasePair &ppair)
 {
-	os	<< ppair.first << "\t["
-		<< ppair.second.get().getSourcePhrase().get() << "] -\t["
-		<< ppair.second.get().getTargetPhrase().get() << ']';
+	printAnchoredPhrasePair(os, ppair, ppair.first.end());
 	return os;
 }
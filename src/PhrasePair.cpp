@@ -38,6 +38,16 @@ bool PhrasePairData::operator==(const PhrasePairData &o) const
 		targetPhrase_ == o.targetPhrase_;
 }
 
+std::vector<std::vector<WordId> > PhrasePairData::getAnnotationWordIds(
+	const std::vector<Phrase> &annotations
+) {
+	std::vector<std::vector<WordId> > ids;
+	ids.reserve(annotations.size());
+	BOOST_FOREACH(const Phrase &a, annotations)
+		ids.push_back(Vocabulary::getIds(a.get()));
+	return ids;
+}
+
 std::size_t hash_value(const PhrasePairData &p)
 {
 	std::size_t seed = 0;
@@ -48,6 +58,11 @@ std::size_t hash_value(const PhrasePairData &p)
 	return seed;
 }
 
+std::ostream &operator<<(std::ostream &os, const SourceSpan &span)
+{
+	return os << '[' << span.start << ',' << span.end() << ')';
+}
+
 WordAlignment::WordAlignment(
 	uint nsrc,
 	uint ntgt,
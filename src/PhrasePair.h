@@ -24,7 +24,9 @@
 #define docent_PhrasePair_h
 
 #include "Docent.h"
+#include "Vocabulary.h"
 
+#include <algorithm>
 #include <vector>
 
 #include <boost/flyweight.hpp>
@@ -175,6 +177,13 @@ private:
 	WordAlignment alignment_;
 	Scores scores_;
 	bool oovFlag_;
+	// Vocabulary IDs of the phrases. They are only valid within one process
+	// and aren't serialised.
+	std::vector<WordId> sourceWordIds_;
+	std::vector<WordId> targetWordIds_;
+	std::vector<std::vector<WordId> > targetAnnotationWordIds_;
+
+	static std::vector<std::vector<WordId> > getAnnotationWordIds(const std::vector<Phrase> &annotations);
 
 public:
 	friend class boost::serialization::access;
@@ -187,6 +196,11 @@ public:
 		ar & alignment_;
 		ar & scores_;
 		ar & oovFlag_;
+		if(Archive::is_loading::value) {
+			sourceWordIds_ = Vocabulary::getIds(sourcePhrase_.get());
+			targetWordIds_ = Vocabulary::getIds(targetPhrase_.get());
+			targetAnnotationWordIds_ = getAnnotationWordIds(targetAnnotations_);
+		}
 	}
 
 	PhrasePairData(
@@ -201,7 +215,10 @@ public:
 		targetAnnotations_(targetAnnotations),
 		alignment_(alignment),
 		scores_(scores),
-		oovFlag_(false)
+		oovFlag_(false),
+		sourceWordIds_(Vocabulary::getIds(sourcePhrase)),
+		targetWordIds_(Vocabulary::getIds(targetPhrase)),
+		targetAnnotationWordIds_(getAnnotationWordIds(targetAnnotations))
 	{}
 
 	PhrasePairData(
@@ -217,7 +234,10 @@ public:
 		targetAnnotations_(targetAnnotations),
 		alignment_(alignment),
 		scores_(scores),
-		oovFlag_(false)
+		oovFlag_(false),
+		sourceWordIds_(Vocabulary::getIds(sourcePhrase)),
+		targetWordIds_(Vocabulary::getIds(targetPhrase)),
+		targetAnnotationWordIds_(getAnnotationWordIds(targetAnnotations))
 	{}
 
 	PhrasePairData(
@@ -228,7 +248,9 @@ public:
 		targetPhrase_(1, oov),
 		alignment_(1, 1),
 		scores_(scores),
-		oovFlag_(true)
+		oovFlag_(true),
+		sourceWordIds_(1, Vocabulary::getId(oov)),
+		targetWordIds_(sourceWordIds_)
 	{
 		alignment_.setLink(0, 0);
 	}
@@ -250,6 +272,14 @@ public:
 		return targetPhrase_;
 	}
 
+	const std::vector<WordId> &getSourceWordIds() const {
+		return sourceWordIds_;
+	}
+
+	const std::vector<WordId> &getTargetWordIds() const {
+		return targetWordIds_;
+	}
+
 	Phrase getTargetAnnotations(uint level) const {
 		static Phrase EMPTY_PHRASE(std::vector<Word>(1, ""));
 		if(oovFlag_)
@@ -268,6 +298,24 @@ public:
 			return getTargetAnnotations(annotationLevel);
 	}
 
+	const std::vector<WordId> &getTargetAnnotationWordIds(uint level) const {
+		static const std::vector<WordId> EMPTY_IDS(1, Vocabulary::getId(""));
+		if(oovFlag_)
+			return EMPTY_IDS;
+		else
+			return targetAnnotationWordIds_[level];
+	}
+
+	const std::vector<WordId> &getTargetWordIdsOrAnnotations(
+		int annotationLevel,
+		bool tokenFlag
+	) const {
+		if(annotationLevel==-1||(oovFlag_&& tokenFlag))
+			return getTargetWordIds();
+		else
+			return getTargetAnnotationWordIds(annotationLevel);
+	}
+
 	const WordAlignment &getWordAlignment() const {
 		return alignment_;
 	}
@@ -289,8 +337,68 @@ public:
 std::size_t hash_value(const PhrasePairData &p);
 
 typedef boost::flyweight<PhrasePairData, boost::flyweights::no_tracking> PhrasePair;
-typedef std::pair<CoverageBitmap, PhrasePair> AnchoredPhrasePair;
-typedef std::list<AnchoredPhrasePair> PhraseSegmentation;
+
+// The source words covered by a phrase pair in a sentence. Phrases always
+// cover a contiguous span, so two integers are enough and copying a phrase
+// segmentation doesn't allocate anything per phrase.
+struct SourceSpan {
+	uint start;
+	uint length;
+
+	SourceSpan() : start(0), length(0) {}
+	SourceSpan(uint s, uint l) : start(s), length(l) {}
+
+	// one past the last word of the span
+	uint end() const {
+		return start + length;
+	}
+
+	bool contains(uint word) const {
+		return word >= start && word < end();
+	}
+
+	bool intersects(const SourceSpan &o) const {
+		return start < o.end() && o.start < end();
+	}
+
+	CoverageBitmap asBitmap(uint sentenceLength) const {
+		CoverageBitmap bm(sentenceLength);
+		bm.set(start, length, true);
+		return bm;
+	}
+
+	bool operator==(const SourceSpan &o) const {
+		return start == o.start && length == o.length;
+	}
+
+	bool operator!=(const SourceSpan &o) const {
+		return !operator==(o);
+	}
+
+	bool operator<(const SourceSpan &o) const {
+		return start < o.start || (start == o.start && length < o.length);
+	}
+
+	template<class Archive>
+	void serialize(Archive &ar, const unsigned int version) {
+		ar & start;
+		ar & length;
+	}
+};
+
+inline std::size_t hash_value(const SourceSpan &span) {
+	std::size_t seed = 0;
+	boost::hash_combine(seed, span.start);
+	boost::hash_combine(seed, span.length);
+	return seed;
+}
+
+std::ostream &operator<<(std::ostream &os, const SourceSpan &span);
+
+typedef std::pair<SourceSpan, PhrasePair> AnchoredPhrasePair;
+// Stored contiguously: the search operations and feature functions mostly
+// work with offsets into the sentence, which a list can only reach by walking.
+typedef std::vector<AnchoredPhrasePair> PhraseSegmentation;
 
 template<class PhrasePairIterator>
 inline uint countTargetWords(PhrasePairIterator from_it, PhrasePairIterator to_it) {
@@ -301,10 +409,18 @@ inline uint countTargetWords(PhrasePairIterator from_it, PhrasePairIterator to_i
 }
 
 template<class PhrasePairContainer>
-inline uint countTargetWords(PhrasePairContainer cont) {
+inline uint countTargetWords(const PhrasePairContainer &cont) {
 	return countTargetWords(cont.begin(), cont.end());
 }
 
+// A complete segmentation covers the whole source sentence.
+inline uint getSentenceLength(const PhraseSegmentation &seg) {
+	uint length = 0;
+	for(PhraseSegmentation::const_iterator it = seg.begin(); it != seg.end(); ++it)
+		length = std::max(length, it->first.end());
+	return length;
+}
+
 struct CompareAnchoredPhrasePairs :
 public std::binary_function<
 	const AnchoredPhrasePair,
@@ -312,7 +428,7 @@ public std::binary_function<
 	bool
 > {
 	typedef boost::tuples::tuple<
-		const CoverageBitmap &,
+		const SourceSpan &,
 		const PhraseData &,
 		const PhraseData &
 	> PhrasePairKey;
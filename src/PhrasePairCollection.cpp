@@ -23,79 +23,69 @@
 #include "PhrasePairCollection.h"
 
 #include <algorithm>
-#include <iterator>
-
-#include <boost/function.hpp>
-#include <boost/iterator/filter_iterator.hpp>
-#include <boost/lambda/lambda.hpp>
-#include <boost/lambda/bind.hpp>
 
 PhrasePairCollection::PhrasePairCollection(
-	uint sentenceLength,
-	Random random
+	uint sentenceLength
 ) :	logger_("PhrasePairCollection"),
-	random_(random),
-	sentenceLength_(sentenceLength)
+	sentenceLength_(sentenceLength),
+	spanOptions_(sentenceLength)
 {}
 
 
 void PhrasePairCollection::addPhrasePair(
-	CoverageBitmap cov,
+	SourceSpan span,
 	PhrasePair phrasePair
 ) {
 	LOG(logger_, verbose, "addPhrasePair "
-		<< cov << " "
+		<< span << " "
 		<< phrasePair.get().getSourcePhrase().get() << " "
 		<< phrasePair.get().getTargetPhrase().get() << " "
 		<< phrasePair.get().getScores()
 	);
-	phrasePairList_.push_back(std::make_pair(cov, phrasePair));
+
+	assert(span.length > 0 && span.end() <= sentenceLength_);
+
+	StartBucket_ &bucket = spanOptions_[span.start];
+	if(bucket.size() < span.length)
+		bucket.resize(span.length);
+	bucket[span.length - 1].push_back(std::make_pair(span, phrasePair));
+}
+
+
+const PhrasePairCollection::SpanOptions_
+*PhrasePairCollection::findSpanOptions(
+	const SourceSpan &span
+) const {
+	if(span.length == 0 || span.start >= spanOptions_.size())
+		return NULL;
+
+	const StartBucket_ &bucket = spanOptions_[span.start];
+	if(span.length > bucket.size())
+		return NULL;
+
+	return &bucket[span.length - 1];
 }
 
 
 PhraseSegmentation
 PhrasePairCollection::proposeSegmentation(
+	Random rnd
 ) const {
 	CoverageBitmap all(sentenceLength_);
 	all.set();
-	return proposeSegmentation(all);
+	return proposeSegmentation(all, rnd);
 }
 
 
 PhraseSegmentation
 PhrasePairCollection::proposeSegmentation(
-	const CoverageBitmap &range
+	const CoverageBitmap &range,
+	Random rnd
 ) const {
-	using namespace boost::lambda;
-
 	assert(range.size() == sentenceLength_);
 
 	PhraseSegmentation seg;
-	bool success;
-
-	std::vector<AnchoredPhrasePair> ppairs;
-	std::remove_copy_if(
-		phrasePairList_.begin(),
-		phrasePairList_.end(),
-		std::back_inserter(ppairs),
-		!boost::lambda::bind(
-			&CoverageBitmap::is_subset_of,
-			boost::lambda::bind<const CoverageBitmap &>(&AnchoredPhrasePair::first, _1),
-			range
-		)
-	);
-	std::sort(
-		ppairs.begin(),
-		ppairs.end(),
-		boost::lambda::bind(
-			&CoverageBitmap::find_first,
-			boost::lambda::bind<const CoverageBitmap &>(&AnchoredPhrasePair::first, _1)
-		) < boost::lambda::bind(
-			&CoverageBitmap::find_first,
-			boost::lambda::bind<const CoverageBitmap &>(&AnchoredPhrasePair::first, _2)
-		)
-	);
-	success = proposeSegmentationLeftRight(range, ppairs.begin(), ppairs.end(), seg);
+	bool success = proposeSegmentationLeftRight(range, seg, rnd);
 
 	assert(success); // TODO: should throw here
 	assert(!seg.empty());
@@ -105,12 +95,9 @@ PhrasePairCollection::proposeSegmentation(
 
 bool PhrasePairCollection::proposeSegmentationLeftRight(
 	const CoverageBitmap &range,
-	std::vector<AnchoredPhrasePair>::const_iterator startit,
-	std::vector<AnchoredPhrasePair>::const_iterator endit,
-	PhraseSegmentation &seg
+	PhraseSegmentation &seg,
+	Random rnd
 ) const {
-	using namespace boost::lambda;
-
 	LOG(logger_, verbose, "proposeSegmentation " << range);
 
 	if(range.none()) {
@@ -118,41 +105,25 @@ bool PhrasePairCollection::proposeSegmentationLeftRight(
 		return true;
 	}
 
-	if(startit == endit) {
-		LOG(logger_, debug, "No phrase pairs available.");
-		return false;
-	}
-
-	LOG(logger_, debug, "                    " << startit->first);
-
+	// The options are the phrase pairs starting at the first uncovered word
+	// that lie entirely within the range. Since the spans are contiguous, they
+	// are the ones up to the first gap in the range.
 	CoverageBitmap::size_type firstBit = range.find_first();
-	std::vector<AnchoredPhrasePair>::const_iterator it1 = std::find_if(
-		startit,
-		endit,
-		boost::lambda::bind(
-			&CoverageBitmap::test,
-			boost::lambda::bind<const CoverageBitmap &>(&AnchoredPhrasePair::first, _1),
-			firstBit
-		)
-	);
-
-	if(it1 == endit) {
+	const StartBucket_ &bucket = spanOptions_[firstBit];
+	uint maxLength = 0;
+	uint noptions = 0;
+	while(maxLength < bucket.size() && firstBit + maxLength < sentenceLength_
+			&& range.test(firstBit + maxLength))
+		noptions += bucket[maxLength++].size();
+
+	if(noptions == 0) {
 		LOG(logger_, debug, "firstBit = " << firstBit);
-		LOG(logger_, debug, "startit->find_first() = " << startit->first.find_first());
 		LOG(logger_, debug, "No matching phrase pair.");
 		return false;
 	}
 
-	std::vector<AnchoredPhrasePair>::const_iterator it2 = std::find_if(
-		it1, endit,
-		boost::lambda::bind(
-			&CoverageBitmap::find_first,
-			boost::lambda::bind<const CoverageBitmap &>(&AnchoredPhrasePair::first, _1)
-		) > firstBit
-	);
-	uint noptions = std::distance(it1, it2);
 	uint choice;
-	std::vector<AnchoredPhrasePair>::const_iterator ph;
+	const AnchoredPhrasePair *ph;
 	CoverageBitmap badChoices(noptions);
 	bool done = false;
 	do {
@@ -162,108 +133,38 @@ bool PhrasePairCollection::proposeSegmentationLeftRight(
 		}
 
 		do {
-			choice = random_.drawFromRange(noptions);
+			choice = rnd.drawFromRange(noptions);
 		} while(badChoices.test(choice));
 		badChoices.set(choice);
-		ph = it1 + choice;
 
-		if((ph->first & range) != ph->first) { // are we covering something we shouldn't?
-			LOG(logger_, debug, "Conflicting coverage:");
-			LOG(logger_, debug, ph->first);
-			LOG(logger_, debug, range);
-			continue;
-		}
+		uint length = 0;
+		uint idx = choice;
+		while(idx >= bucket[length].size())
+			idx -= bucket[length++].size();
+		ph = &bucket[length][idx];
 
 		LOG(logger_, debug, "selected            " << ph->first);
-		CoverageBitmap::size_type i = firstBit, next;
-		LOG(logger_, debug, "First bit: " << i);
-		while((next = ph->first.find_next(i)) == i + 1) // find first gap in phrase
-			i = next;
-		i++;
-		LOG(logger_, debug, "Next unset bit: " << i);
-		std::vector<AnchoredPhrasePair>::const_iterator it2new = std::find_if(
-			it2,
-			endit,
-			boost::lambda::bind(
-				&CoverageBitmap::find_first,
-				boost::lambda::bind<const CoverageBitmap &>(&AnchoredPhrasePair::first, _1)
-			) >= i
-		);
-
-		done = proposeSegmentationLeftRight(range - ph->first, it2new, endit, seg);
+		CoverageBitmap rest(range);
+		rest.reset(ph->first.start, ph->first.length);
+		done = proposeSegmentationLeftRight(rest, seg, rnd);
 	} while(!done);
 
 	LOG(logger_, debug, "Proposing " << *ph);
-	seg.push_front(*ph);
+	seg.insert(seg.begin(), *ph);
 	return true;
 }
 
-bool PhrasePairCollection::proposeSegmentationRandomChoice(
-	CoverageBitmap range,
-	const PhrasePairList_ &list,
-	PhraseSegmentation &seg
-) const {
-	using namespace boost::lambda;
-
-	LOG(logger_, verbose, "proposeSegmentation " << range);
-
-	if(range.none())
-		return true;
-
-	typedef boost::function<bool(const AnchoredPhrasePair &)> FilterPred;
-	FilterPred filterPredicate = boost::lambda::bind(
-		&CoverageBitmap::is_subset_of,
-		boost::lambda::bind<const CoverageBitmap &>(&AnchoredPhrasePair::first, _1),
-		range
-	);
-	boost::filter_iterator<FilterPred,PhraseSegmentation::const_iterator> fit1 = boost::make_filter_iterator(
-		filterPredicate, list.begin(), list.end()
-	);
-	boost::filter_iterator<FilterPred,PhraseSegmentation::const_iterator> fit2 = boost::make_filter_iterator(
-		filterPredicate, list.end(), list.end()
-	);
-	PhrasePairList_ sublist(fit1, fit2);
-
-	while(!sublist.empty()) {
-		uint phidx = random_.drawFromRange(sublist.size());
-		PhrasePairList_::const_iterator ph = sublist.begin();
-		while(phidx--)
-			++ph;
-		LOG(logger_, debug, "selected            " << ph->first);
-		if(proposeSegmentationRandomChoice(range - ph->first, sublist, seg)) {
-			LOG(logger_, debug, "Proposing " << *ph);
-			seg.push_front(*ph);
-			return true;
-		}
-		sublist.remove_if(
-			boost::lambda::bind(&AnchoredPhrasePair::first, _1) == ph->first
-		);
-	}
-
-	return false;
-}
-
 const AnchoredPhrasePair
 &PhrasePairCollection::proposeAlternativeTranslation(
-	const AnchoredPhrasePair &old
+	const AnchoredPhrasePair &old,
+	Random rnd
 ) const {
-	using namespace boost::lambda;
-
-	typedef boost::function<bool(const AnchoredPhrasePair &)> FilterPred;
-	FilterPred filterPredicate =
-		boost::lambda::bind<const CoverageBitmap &>(&AnchoredPhrasePair::first, _1) == old.first;
-	boost::filter_iterator<FilterPred,PhraseSegmentation::const_iterator> fit1 =
-		boost::make_filter_iterator(filterPredicate, phrasePairList_.begin(), phrasePairList_.end());
-	boost::filter_iterator<FilterPred,PhraseSegmentation::const_iterator> fit2 =
-		boost::make_filter_iterator(filterPredicate, phrasePairList_.end(), phrasePairList_.end());
-
-	std::vector<const AnchoredPhrasePair *> sublist;
-	std::transform(fit1, fit2, std::back_inserter(sublist), &_1);
-	if(sublist.size() == 0)
+	const SpanOptions_ *options = findSpanOptions(old.first);
+	if(options == NULL || options->empty())
 		return old;
 
-	uint phidx = random_.drawFromRange(sublist.size());
-	return *sublist[phidx];
+	uint phidx = rnd.drawFromRange(options->size());
+	return (*options)[phidx];
 }
 
 bool PhrasePairCollection::phrasesExist(
@@ -273,19 +174,9 @@ bool PhrasePairCollection::phrasesExist(
 		pit1 != phraseSegmentation.end();
 		++pit1
 	) {
-		bool found = false;
-		for(PhrasePairList_::const_iterator pit2 = phrasePairList_.begin();
-			pit2 != phrasePairList_.end();
-			++pit2
-		) {
-			if (*pit1  == *pit2) {
-				found = true;
-				break;
-			}
-		}
-		if (!found) {
+		const SpanOptions_ *options = findSpanOptions(pit1->first);
+		if(options == NULL || std::find(options->begin(), options->end(), *pit1) == options->end())
 			return false;
-		}
 	}
 	return true;
 }
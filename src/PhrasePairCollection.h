@@ -27,8 +27,8 @@
 #include "PhrasePair.h"
 #include "Random.h"
 
-#include <iterator>
-#include <list>
+#include <algorithm>
+#include <vector>
 
 class PhraseTable;
 
@@ -38,28 +38,26 @@ class PhrasePairCollection {
 private:
 	Logger logger_;
 
-	Random random_;
-
 	uint sentenceLength_;
-	typedef std::list<AnchoredPhrasePair> PhrasePairList_;
-	PhrasePairList_ phrasePairList_;
+
+	// The translation options are indexed by span: spanOptions_[start][length - 1]
+	// holds the options of the source words start .. start + length - 1 in the
+	// order in which they were added.
+	typedef std::vector<AnchoredPhrasePair> SpanOptions_;
+	typedef std::vector<SpanOptions_> StartBucket_;
+	std::vector<StartBucket_> spanOptions_;
 
 	PhrasePairCollection(
-		uint sentenceLength,
-		Random random
+		uint sentenceLength
 	);
-	void addPhrasePair(CoverageBitmap cov, PhrasePair phrasePair);
+	void addPhrasePair(SourceSpan span, PhrasePair phrasePair);
+
+	const SpanOptions_ *findSpanOptions(const SourceSpan &span) const;
 
 	bool proposeSegmentationLeftRight(
 		const CoverageBitmap &range,
-		std::vector<AnchoredPhrasePair>::const_iterator startit,
-		std::vector<AnchoredPhrasePair>::const_iterator endit,
-		PhraseSegmentation &seg
-	) const;
-	bool proposeSegmentationRandomChoice(
-		CoverageBitmap range,
-		const PhrasePairList_ &list,
-		PhraseSegmentation &seg
+		PhraseSegmentation &seg,
+		Random rnd
 	) const;
 
 public:
@@ -69,12 +67,14 @@ public:
 
 	template<class Iterator>
 	void copyPhrasePairs(Iterator to_it) const {
-		std::copy(phrasePairList_.begin(), phrasePairList_.end(), to_it);
+		for(uint i = 0; i < spanOptions_.size(); i++)
+			for(uint j = 0; j < spanOptions_[i].size(); j++)
+				to_it = std::copy(spanOptions_[i][j].begin(), spanOptions_[i][j].end(), to_it);
 	}
 
-	PhraseSegmentation proposeSegmentation() const;
-	PhraseSegmentation proposeSegmentation(const CoverageBitmap &range) const;
-	const AnchoredPhrasePair &proposeAlternativeTranslation(const AnchoredPhrasePair &old) const;
+	PhraseSegmentation proposeSegmentation(Random rnd) const;
+	PhraseSegmentation proposeSegmentation(const CoverageBitmap &range, Random rnd) const;
+	const AnchoredPhrasePair &proposeAlternativeTranslation(const AnchoredPhrasePair &old, Random rnd) const;
 	bool phrasesExist(const PhraseSegmentation& phraseSegmentation) const;
 };
 
@@ -0,0 +1,118 @@
+/*
+ *  PooledObject.cpp
+ *
+ *  Copyright 2012 by Christian Hardmeier. All rights reserved.
+ *
+ *  This file is part of Docent, a document-level decoder for phrase-based
+ *  statistical machine translation.
+ *
+ *  Docent is free software: you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation, either version 3 of the License, or (at your option) any later
+ *  version.
+ *
+ *  Docent is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  Docent. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PooledObject.h"
+
+#include <new>
+
+#include <boost/thread/tss.hpp>
+
+namespace {
+
+const std::size_t granularity = 16;
+const uint numberOfSizeClasses = 32;
+// Blocks beyond this number are returned to the global heap. This limits
+// the memory held by a thread that mostly frees objects allocated by other
+// threads.
+const uint maxFreeBlocks = 4096;
+
+struct FreeBlock {
+	FreeBlock *next;
+};
+
+struct FreeLists {
+	FreeBlock *head[numberOfSizeClasses];
+	uint length[numberOfSizeClasses];
+
+	FreeLists() {
+		for(uint i = 0; i < numberOfSizeClasses; i++) {
+			head[i] = NULL;
+			length[i] = 0;
+		}
+	}
+
+	~FreeLists() {
+		for(uint i = 0; i < numberOfSizeClasses; i++)
+			while(head[i] != NULL) {
+				FreeBlock *next = head[i]->next;
+				::operator delete(head[i]);
+				head[i] = next;
+			}
+	}
+};
+
+// The thread_specific_ptr only takes care of deleting the free lists when
+// the thread exits. Looking them up through it is much slower than through
+// a plain thread-local pointer.
+boost::thread_specific_ptr<FreeLists> threadFreeListsOwner;
+__thread FreeLists *threadFreeLists = NULL;
+
+inline uint getSizeClass(std::size_t size) {
+	return size == 0 ? 1 : (size + granularity - 1) / granularity;
+}
+
+inline FreeLists &getFreeLists() {
+	if(threadFreeLists == NULL) {
+		threadFreeLists = new FreeLists();
+		threadFreeListsOwner.reset(threadFreeLists);
+	}
+	return *threadFreeLists;
+}
+
+} // namespace
+
+void *PooledObject::operator new(std::size_t size) {
+	uint sizeClass = getSizeClass(size);
+	if(sizeClass >= numberOfSizeClasses)
+		return ::operator new(size);
+
+	FreeLists &lists = getFreeLists();
+	FreeBlock *block = lists.head[sizeClass];
+	if(block == NULL)
+		return ::operator new(sizeClass * granularity);
+
+	lists.head[sizeClass] = block->next;
+	lists.length[sizeClass]--;
+	return block;
+}
+
+void PooledObject::operator delete(void *p, std::size_t size) {
+	if(p == NULL)
+		return;
+
+	uint sizeClass = getSizeClass(size);
+	if(sizeClass >= numberOfSizeClasses) {
+		::operator delete(p);
+		return;
+	}
+
+	FreeLists &lists = getFreeLists();
+	if(lists.length[sizeClass] >= maxFreeBlocks) {
+		::operator delete(p);
+		return;
+	}
+
+	FreeBlock *block = static_cast<FreeBlock *>(p);
+	block->next = lists.head[sizeClass];
+	lists.head[sizeClass] = block;
+	lists.length[sizeClass]++;
+}
@@ -0,0 +1,52 @@
+/*
+ *  PooledObject.h
+ *
+ *  Copyright 2012 by Christian Hardmeier. All rights reserved.
+ *
+ *  This file is part of Docent, a document-level decoder for phrase-based
+ *  statistical machine translation.
+ *
+ *  Docent is free software: you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation, either version 3 of the License, or (at your option) any later
+ *  version.
+ *
+ *  Docent is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  Docent. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef docent_PooledObject_h
+#define docent_PooledObject_h
+
+#include "Docent.h"
+
+#include <cstddef>
+
+/**
+ * Base class for small objects that are created and destroyed at a high
+ * rate, such as search steps and the state modifications of the feature
+ * functions, most of which only live for a single rejected proposal.
+ * Memory freed by these objects is kept in per-thread free lists, one for
+ * each size class, and reused for the next object of the same size class
+ * allocated in the same thread. Objects larger than the largest size class
+ * are allocated from the global heap.
+ *
+ * Derived classes that are deleted through a base class pointer must have
+ * a virtual destructor so the correct size is passed to operator delete.
+ */
+class PooledObject {
+public:
+	static void *operator new(std::size_t size);
+	static void operator delete(void *p, std::size_t size);
+
+protected:
+	PooledObject() {}
+	~PooledObject() {}
+};
+
+#endif
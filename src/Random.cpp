@@ -23,6 +23,9 @@
 #include "Random.h"
 
 #include <cstdio>
+#include <sstream>
+
+#include <boost/random/seed_seq.hpp>
 
 void Random::seed() {
 	FILE *urandom = std::fopen("/dev/urandom", "rb");
@@ -49,6 +52,29 @@ void Random::seed(uint seed) {
 	impl_->seed(seed);
 }
 
+Random Random::createStream(uint id) const {
+	Random stream;
+	stream.impl_->seedStream(impl_->seedSequence_, id);
+	return stream;
+}
+
+std::string Random::getGeneratorState() const {
+	std::ostringstream os;
+	os << impl_->generator_;
+	return os.str();
+}
+
+void Random::setGeneratorState(const std::string &state) {
+	std::istringstream is(state);
+	RandomImplementation::RandomGenerator_ generator;
+	is >> generator;
+	if(!is) {
+		LOG(impl_->logger_, error, "Invalid random generator state in checkpoint.");
+		BOOST_THROW_EXCEPTION(FileFormatException());
+	}
+	impl_->generator_ = generator;
+}
+
 RandomImplementation::RandomImplementation()
 :	logger_("RandomImplementation"),
 	generator_(),
@@ -56,6 +82,14 @@ RandomImplementation::RandomImplementation()
 {}
 
 void RandomImplementation::seed(uint seed) {
+	seedSequence_.assign(1, seed);
 	generator_.seed(seed);
 	LOG(logger_, normal, "Random number generator seed: " << seed);
 }
+
+void RandomImplementation::seedStream(const std::vector<uint> &parentSequence, uint id) {
+	seedSequence_ = parentSequence;
+	seedSequence_.push_back(id);
+	boost::random::seed_seq seq(seedSequence_.begin(), seedSequence_.end());
+	generator_.seed(seq);
+}
@@ -28,6 +28,7 @@
 #include <algorithm>
 #include <limits>
 #include <numeric>
+#include <string>
 #include <vector>
 
 #include <boost/random/geometric_distribution.hpp>
@@ -55,10 +56,16 @@ private:
 	mutable RandomGenerator_ generator_;
 	UintGenerator uintGenerator_;
 
+	// The seed of the main generator followed by the identifiers of the
+	// streams this generator was derived from.
+	std::vector<uint> seedSequence_;
+
 	RandomImplementation(const RandomImplementation &o);
 	RandomImplementation &operator=(const RandomImplementation &);
 	RandomImplementation();
 
+	void seedStream(const std::vector<uint> &parentSequence, uint id);
+
 public:
 	void seed(uint seed);
 
@@ -101,6 +108,29 @@ public:
 	void seed();
 	void seed(uint seed);
 
+	// Creates an independent random number stream determined by the seed of
+	// this generator and the identifier of the stream (e.g., a document number).
+	// The new stream doesn't share any state with this one, so the numbers it
+	// yields don't depend on what is drawn from other streams.
+	Random createStream(uint id) const;
+
+	// Sub-streams of a document stream that are used for different purposes
+	// live in separate branches of the stream tree, so that, e.g., the stream
+	// of replica i never replays the draws made for sentence i.
+	enum StreamPurpose {
+		SentenceInitialisationStream = 0,
+		ReplicaStream = 1
+	};
+
+	Random createStream(StreamPurpose purpose, uint id) const {
+		return createStream(static_cast<uint>(purpose)).createStream(id);
+	}
+
+	// The internal state of the generator as a string, used to save and
+	// restore it in search checkpoints.
+	std::string getGeneratorState() const;
+	void setGeneratorState(const std::string &state);
+
 	uint drawFromRange(
 		uint noptions
 	) const {
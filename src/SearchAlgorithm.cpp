@@ -23,6 +23,7 @@
 #include "SearchAlgorithm.h"
 
 #include "LocalBeamSearch.h"
+#include "ParallelTempering.h"
 #include "SimulatedAnnealing.h"
 
 SearchAlgorithm
@@ -35,6 +36,8 @@ SearchAlgorithm
 		return new SimulatedAnnealing(config, params);
 	else if(algo == "local-beam-search")
 		return new LocalBeamSearch(config, params);
+	else if(algo == "parallel-tempering")
+		return new ParallelTempering(config, params);
 	//else if(algo == "metropolis-hastings-sampler")
 	//	return new MetropolisHastingsSampler(config, params);
 	else {
@@ -43,3 +46,22 @@ SearchAlgorithm
 		BOOST_THROW_EXCEPTION(ConfigurationException());
 	}
 }
+
+void SearchAlgorithm::saveCheckpoint(
+	const SearchState *sstate,
+	boost::archive::binary_oarchive &ar
+) const {
+	Logger logger("SearchAlgorithm");
+	LOG(logger, error, "This search algorithm does not support checkpoints.");
+	BOOST_THROW_EXCEPTION(ConfigurationException());
+}
+
+SearchState
+*SearchAlgorithm::loadCheckpoint(
+	boost::shared_ptr<DocumentState> doc,
+	boost::archive::binary_iarchive &ar
+) const {
+	Logger logger("SearchAlgorithm");
+	LOG(logger, error, "This search algorithm does not support checkpoints.");
+	BOOST_THROW_EXCEPTION(ConfigurationException());
+}
@@ -32,6 +32,12 @@
 
 #include <boost/shared_ptr.hpp>
 
+namespace boost {
+namespace archive {
+	class binary_iarchive;
+	class binary_oarchive;
+}}
+
 class DecoderConfiguration;
 class DocumentState;
 class Parameters;
@@ -60,8 +66,22 @@ public:
 		Float oldScore
 	) :	logger_("AcceptanceDecision")
 	{
+		init(rnd.draw01(), T, oldScore);
+	}
+
+	// Same as above, but with the uniform random number d drawn in advance.
+	AcceptanceDecision(
+		Float d,
+		Float T,
+		Float oldScore
+	) :	logger_("AcceptanceDecision")
+	{
+		init(d, T, oldScore);
+	}
+
+private:
+	void init(Float d, Float T, Float oldScore) {
 		// compute acceptance threshold for acceptance with probability exp((old - new) / T)
-		Float d = rnd.draw01();
 		threshold_ = T * log(d) + oldScore;
 
 		d_ = d;
@@ -69,6 +89,8 @@ public:
 		oldScore_ = oldScore;
 	}
 
+public:
+
 	bool operator()(Float newScore) const {
 		LOG(logger_, debug, "new:                  " << newScore);
 		LOG(logger_, debug, "old:                  " << oldScore_);
@@ -86,6 +108,8 @@ struct SearchState {
 	virtual ~SearchState() {}
 	virtual const boost::shared_ptr<DocumentState>
 	&getLastDocumentState() = 0;
+	// number of search steps done so far with this state
+	virtual uint getNumberOfSteps() const = 0;
 };
 
 struct SearchAlgorithm {
@@ -129,7 +153,35 @@ struct SearchAlgorithm {
 		SearchState *state = createState(doc);
 		search(state, nbest);
 		delete state;
+		finishDocument();
 	}
+
+	// Frontends decoding several documents call setJobSize before the
+	// search and finishDocument whenever a document is done, so that
+	// a job time limit can be shared out among the documents. The
+	// search() overload for whole documents calls finishDocument itself.
+	virtual void setJobSize(
+		uint documents,
+		uint concurrency
+	) const {}
+
+	virtual void finishDocument() const {}
+
+	// Save a search state between two calls to search() so that the search
+	// can be resumed after restarting the decoder. The document state itself
+	// is saved separately with DocumentState::saveCheckpoint; loadCheckpoint
+	// continues the search from doc, restored from that checkpoint.
+	// By default, checkpoints are not supported.
+	virtual void saveCheckpoint(
+		const SearchState *sstate,
+		boost::archive::binary_oarchive &ar
+	) const;
+
+	virtual SearchState
+	*loadCheckpoint(
+		boost::shared_ptr<DocumentState> doc,
+		boost::archive::binary_iarchive &ar
+	) const;
 };
 
 #endif
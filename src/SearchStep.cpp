@@ -28,6 +28,7 @@
 
 #include <algorithm>
 #include <limits>
+#include <numeric>
 
 #include <boost/lambda/lambda.hpp>
 #include <boost/lambda/bind.hpp>
@@ -47,7 +48,8 @@ SearchStep::SearchStep(
 	operation_(op),
 	modificationsConsolidated_(true),
 	scores_(doc.getScores().size()),
-	scoreState_(NoScores)
+	scoreState_(NoScores),
+	modelsComputed_(0)
 {}
 
 SearchStep::~SearchStep()
@@ -77,7 +79,7 @@ const {
 		if(prev->sentno == it->sentno && prev->to == it->from) {
 			it->from = prev->from;
 			it->from_it = prev->from_it;
-			it->proposal.splice(it->proposal.begin(), prev->proposal);
+			it->proposal.insert(it->proposal.begin(), prev->proposal.begin(), prev->proposal.end());
 
 			prev->sentno = std::numeric_limits<uint>::max();
 			removed++;
@@ -126,45 +128,53 @@ const {
 	scoreState_ = ScoresEstimated;
 }
 
+void SearchStep::computeNextModelScore()
+const {
+	const DecoderConfiguration::FeatureFunctionList &ff = configuration_.getFeatureFunctions();
+	uint i = configuration_.getFeatureEvaluationOrder()[modelsComputed_];
+	uint scoreIndex = ff[i].getScoreIndex();
+	stateModifications_[i] = ff[i].updateScore(
+		document_,
+		*this,
+		featureStates_[i],
+		stateModifications_[i],
+		document_.getScores().begin() + scoreIndex,
+		scores_.begin() + scoreIndex
+	);
+	modelsComputed_++;
+}
+
 void SearchStep::computeScores()
 const {
-	switch(scoreState_) {
-	case NoScores:
-		estimateScores();
-	case ScoresEstimated:
-		break;
-	case ScoresComputed:
+	if(scoreState_ == ScoresComputed)
 		return;
-	}
 
-	Scores::const_iterator oldscoreit = document_.getScores().begin();
-	Scores::iterator scoreit = scores_.begin();
-	const DecoderConfiguration::FeatureFunctionList &ff = configuration_.getFeatureFunctions();
-	for(uint
-		i = 0;
-		i < ff.size();
-		scoreit += ff[i].getNumberOfScores(), oldscoreit += ff[i].getNumberOfScores(), i++
-	) {
-		stateModifications_[i] = ff[i].updateScore(
-			document_,
-			*this,
-			featureStates_[i],
-			stateModifications_[i],
-			oldscoreit,
-			scoreit
-		);
-	}
+	estimateScores();
+	while(modelsComputed_ < configuration_.getFeatureFunctions().size())
+		computeNextModelScore();
 	scoreState_ = ScoresComputed;
 }
 
-bool SearchStep::isProvisionallyAcceptable(
+bool SearchStep::isAcceptable(
 	const AcceptanceDecision &accept
 ) const {
 	estimateScores();
-	Float estScore = std::inner_product(
+	for(;;) {
+		if(!accept(getWeightedScores()))
+			return false;
+		if(modelsComputed_ == configuration_.getFeatureFunctions().size()) {
+			scoreState_ = ScoresComputed;
+			return true;
+		}
+		computeNextModelScore();
+	}
+}
+
+Float SearchStep::getWeightedScores()
+const {
+	return std::inner_product(
 		scores_.begin(), scores_.end(),
 		configuration_.getFeatureWeights().begin(),
 		static_cast<Float>(0)
 	);
-	return accept(estScore);
 }
@@ -26,6 +26,7 @@
 #include "DocumentState.h"
 #include "FeatureFunction.h"
 #include "PhrasePair.h"
+#include "PooledObject.h"
 #include "StateOperation.h"
 
 #include <vector>
@@ -33,7 +34,7 @@
 class AcceptanceDecision;
 class DecoderConfiguration;
 
-class SearchStep {
+class SearchStep : public PooledObject {
 public:
 	struct Modification {
 		uint sentno;
@@ -75,11 +76,15 @@ private:
 	mutable bool modificationsConsolidated_;
 	mutable Scores scores_;
 	mutable enum ScoreState { NoScores, ScoresEstimated, ScoresComputed } scoreState_;
+	// number of models, in order of evaluation cost, whose exact scores are known
+	mutable uint modelsComputed_;
 
 	void consolidateModifications() const;
 	static bool compareModifications(const Modification &a, const Modification &b);
 	void estimateScores() const;
+	void computeNextModelScore() const;
 	void computeScores() const;
+	Float getWeightedScores() const;
 
 public:
 	SearchStep(
@@ -131,26 +136,20 @@ public:
 		return scores_;
 	}
 
-	bool isProvisionallyAcceptable(const AcceptanceDecision &accept) const;
+	// Computes only as many exact model scores as needed to decide whether
+	// the step is accepted. Can be called again with a different decision.
+	bool isAcceptable(const AcceptanceDecision &accept) const;
 
 	Float getScore() const {
 		computeScores();
-		return std::inner_product(
-			scores_.begin(),
-			scores_.end(),
-			configuration_.getFeatureWeights().begin(),
-			static_cast<Float>(0)
-		);
+		return getWeightedScores();
 	}
 
+	// Upper bound of the score from the exact scores computed so far and the
+	// estimates of the other models.
 	Float getScoreEstimate() const {
 		estimateScores();
-		return std::inner_product(
-			scores_.begin(),
-			scores_.end(),
-			configuration_.getFeatureWeights().begin(),
-			static_cast<Float>(0)
-		);
+		return getWeightedScores();
 	}
 
 	void setStateModifications(uint i, FeatureFunction::StateModifications *mod) {
@@ -22,30 +22,51 @@
 
 #include "SimulatedAnnealing.h"
 
+#include "BestStateJournal.h"
 #include "CoolingSchedule.h"
 #include "NbestStorage.h"
 #include "Random.h"
 #include "SearchStep.h"
 #include "StateGenerator.h"
+#include "WorkerPool.h"
 
+#include <algorithm>
 #include <limits>
 
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+
 struct SimulatedAnnealingSearchState
 :	public SearchState
 {
 	boost::shared_ptr<DocumentState> document;
+	Random random;
 	CoolingSchedule *schedule;
+	boost::scoped_ptr<WorkerPool> workers;
+	boost::scoped_ptr<BestStateJournal> journal;
 	uint nsteps;
+	uint nspeculative;
+	uint nwasted;
+	Float searchTime;
 	bool aborted;
 
 	SimulatedAnnealingSearchState(
 		boost::shared_ptr<DocumentState> doc,
-		const Parameters &params
+		const Parameters &params,
+		uint nthreads
 	) :	document(doc),
+		random(doc->getRandom()),
 		nsteps(0),
+		nspeculative(0),
+		nwasted(0),
+		searchTime(0),
 		aborted(false)
 	{
 		schedule = CoolingSchedule::createCoolingSchedule(params);
+		if(nthreads > 1)
+			workers.reset(new WorkerPool(nthreads));
 	}
 
 	~SimulatedAnnealingSearchState() {
@@ -55,22 +76,55 @@ struct SimulatedAnnealingSearchState
 	const boost::shared_ptr<DocumentState>& getLastDocumentState() {
 		return document;
 	}
+
+	uint getNumberOfSteps() const {
+		return nsteps;
+	}
+
+	Float getBestScore(const NbestStorage &nbest) const {
+		if(journal)
+			return std::max(journal->getBestScore(), nbest.getBestScore());
+		else
+			return nbest.getBestScore();
+	}
 };
 
 SimulatedAnnealing::SimulatedAnnealing(
 	const DecoderConfiguration &config,
 	const Parameters &params
 ) :	logger_("SimulatedAnnealing"),
-	random_(config.getRandom()),
 	generator_(config.getStateGenerator()),
+	timeLimit_(params),
 	parameters_(params)
 {
 	totalMaxSteps_ = params.get<uint>("max-steps");
 	targetScore_ = params.get<Float>("target-score", std::numeric_limits<Float>::infinity());
+	batchSize_ = params.get<uint>("speculative-batch", 1);
+	nthreads_ = params.get<uint>("speculative-threads", batchSize_);
+
+	if(batchSize_ == 0) {
+		LOG(logger_, error, "speculative-batch must be at least 1.");
+		BOOST_THROW_EXCEPTION(ConfigurationException());
+	}
 }
 
 SearchState *SimulatedAnnealing::createState(boost::shared_ptr<DocumentState> doc) const {
-	return new SimulatedAnnealingSearchState(doc, parameters_);
+	return new SimulatedAnnealingSearchState(doc, parameters_, batchSize_ > 1 ? nthreads_ : 1);
+}
+
+// Runs in the worker threads. The proposals in a batch only read the document
+// state they were generated from, so they can be scored concurrently. Steps
+// are scored as far as needed for the acceptance decision at the temperature
+// in effect at the start of the batch; search() catches up on the rest lazily.
+void SimulatedAnnealing::evaluateStep(
+	const std::vector<SearchStep *> &batch,
+	const std::vector<Float> &draws,
+	Float temperature,
+	Float oldScore,
+	uint k
+) const {
+	AcceptanceDecision accept(draws[k], temperature, oldScore);
+	batch[k]->isAcceptable(accept);
 }
 
 void SimulatedAnnealing::search(
@@ -84,57 +138,131 @@ void SimulatedAnnealing::search(
 
 	LOG(logger_, debug, *state.document);
 
-	nbest.offer(state.document);
+	// If only the single best state is wanted, we don't copy the document
+	// each time the score improves, but build the best state at the end.
+	if(nbest.getMaxSize() == 1 && !state.journal)
+		state.journal.reset(new BestStateJournal(*state.document));
+
+	if(!state.journal)
+		nbest.offer(state.document);
+
+	TimeLimit::TimePoint start = TimeLimit::now();
+	bool timeUp = false;
+	uint nextTimeCheck = 0;
 
 	uint accepted = 0;
 	uint i = 0;
+	std::vector<SearchStep *> batch;
+	std::vector<Float> draws;
 	while(
 		!state.aborted
 		&& !state.schedule->isDone()
 		&& i < maxSteps
 		&& state.nsteps < totalMaxSteps_
 		&& accepted < maxAccepted
-		&& nbest.getBestScore() < targetScore_
+		&& state.getBestScore(nbest) < targetScore_
 	) {
-		AcceptanceDecision accept(
-			random_,
-			state.schedule->getTemperature(),
-			state.document->getScore()
-		);
-		SearchStep *step = generator_.createSearchStep(*state.document);
-		if(step == NULL) {
-			state.aborted = true;
-			break;
+		if(timeLimit_.isLimited() && i >= nextTimeCheck) {
+			TimeLimit::TimePoint now = TimeLimit::now();
+			Float used = state.searchTime + TimeLimit::secondsBetween(start, now);
+			Float remaining = timeLimit_.getRemainingTime(used, now);
+			if(remaining <= 0) {
+				timeUp = true;
+				break;
+			}
+			state.schedule->setTimeFraction(used / (used + remaining));
+			nextTimeCheck = i + TimeLimit::checkInterval;
+		}
+
+		// All proposals of a batch are generated from the current document
+		// state. Since the state only changes when a step is accepted, trying
+		// them in order and stopping at the first accepted one is equivalent
+		// to proposing them one at a time. Each proposal gets its random number
+		// for the acceptance decision drawn just before it is generated.
+		uint batchSize = std::min(batchSize_, std::min(maxSteps - i, totalMaxSteps_ - state.nsteps));
+		bool exhausted = false;
+		for(uint k = 0; k < batchSize; k++) {
+			Float d = state.random.draw01();
+			SearchStep *step = generator_.createSearchStep(*state.document);
+			if(step == NULL) {
+				exhausted = true;
+				break;
+			}
+			draws.push_back(d);
+			batch.push_back(step);
 		}
-		state.document->registerAttemptedMove(step);
-		if(step->isProvisionallyAcceptable(accept)) {
-			if(accept(step->getScore())) {
+
+		if(state.workers && batch.size() > 1) {
+			state.nspeculative += batch.size();
+			state.workers->run(batch.size(), boost::bind(&SimulatedAnnealing::evaluateStep, this,
+				boost::cref(batch), boost::cref(draws),
+				state.schedule->getTemperature(), state.document->getScore(), _1));
+		}
+
+		uint k = 0;
+		bool stepAccepted = false;
+		while(k < batch.size() && !stepAccepted && !state.schedule->isDone()) {
+			SearchStep *step = batch[k++];
+			AcceptanceDecision accept(
+				draws[k - 1],
+				state.schedule->getTemperature(),
+				state.document->getScore()
+			);
+			state.document->registerAttemptedMove(step);
+			if(step->isAcceptable(accept)) {
 				LOG(logger_, debug, "Accepting.");
 				state.schedule->step(step->getScore(), true);
+				if(state.journal)
+					state.journal->recordStep(*step);
 				state.document->applyModifications(step);
 				LOG(logger_, debug, *state.document);
-				nbest.offer(state.document);
+				if(state.journal)
+					state.journal->update(*state.document);
+				else
+					nbest.offer(state.document);
 				accepted++;
+				stepAccepted = true;
 			} else {
-				state.schedule->step(step->getScore(), false);
+				// The bound at which a step was rejected depends on the order
+				// of evaluation, so schedules that learn from rejected steps
+				// get the exact score.
+				if(state.schedule->usesRejectedScores())
+					state.schedule->step(step->getScore(), false);
+				else
+					state.schedule->step(step->getScoreEstimate(), false);
 				LOG(logger_, debug, "Discarding.");
 				delete step;
 			}
-		} else {
-			state.schedule->step(step->getScoreEstimate(), false);
-			LOG(logger_, debug, "Discarding.");
-			delete step;
+			i++;
+			state.nsteps++;
 		}
-		i++;
-		state.nsteps++;
+
+		// Proposals behind an accepted step refer to an outdated document state.
+		if(state.workers)
+			state.nwasted += batch.size() - k;
+		for(; k < batch.size(); k++)
+			delete batch[k];
+		batch.clear();
+		draws.clear();
+
+		if(exhausted && !stepAccepted)
+			state.aborted = true;
 	}
 
+	state.searchTime += TimeLimit::secondsBetween(start, TimeLimit::now());
+
+	if(state.journal)
+		state.journal->offerBest(state.document, nbest);
+
 	if(state.aborted)
 		LOG(logger_, normal, "Document search aborted.");
 
 	if(state.schedule->isDone())
 		LOG(logger_, normal, "End of cooling schedule reached.");
 
+	if(timeUp)
+		LOG(logger_, normal, "Time limit reached after " << state.searchTime << " seconds.");
+
 	if(accepted >= maxAccepted)
 		LOG(logger_, normal, "Maximum number of accepted steps (" << maxAccepted << ") reached.");
 
@@ -147,6 +275,10 @@ void SimulatedAnnealing::search(
 	if(nbest.getBestScore() > targetScore_)
 		LOG(logger_, normal, "Found solution with better than target score.");
 
+	if(state.nspeculative > 0)
+		LOG(logger_, normal, state.nwasted << " of " << state.nspeculative
+			<< " speculatively evaluated proposals were discarded unused.");
+
 	DocumentState::MoveCounts::const_iterator it = state.document->getMoveCounts().begin();
 	while(it != state.document->getMoveCounts().end()) {
 		LOG(logger_, normal,
@@ -157,3 +289,37 @@ void SimulatedAnnealing::search(
 		++it;
 	}
 }
+
+// The best state journal is not saved. Its best state has been passed on to
+// the n-best list at the end of the last call to search(), so a new journal
+// started from the current state finds the same best state.
+void SimulatedAnnealing::saveCheckpoint(
+	const SearchState *sstate,
+	boost::archive::binary_oarchive &ar
+) const {
+	const SimulatedAnnealingSearchState
+		&state = dynamic_cast<const SimulatedAnnealingSearchState &>(*sstate);
+
+	ar << state.nsteps;
+	ar << state.nspeculative;
+	ar << state.nwasted;
+	ar << state.searchTime;
+	ar << state.aborted;
+	state.schedule->saveCheckpoint(ar);
+}
+
+SearchState
+*SimulatedAnnealing::loadCheckpoint(
+	boost::shared_ptr<DocumentState> doc,
+	boost::archive::binary_iarchive &ar
+) const {
+	SimulatedAnnealingSearchState
+		*state = static_cast<SimulatedAnnealingSearchState *>(createState(doc));
+	ar >> state->nsteps;
+	ar >> state->nspeculative;
+	ar >> state->nwasted;
+	ar >> state->searchTime;
+	ar >> state->aborted;
+	state->schedule->loadCheckpoint(ar);
+	return state;
+}
@@ -26,25 +26,49 @@
 #include "Docent.h"
 #include "DecoderConfiguration.h"
 #include "SearchAlgorithm.h"
+#include "TimeLimit.h"
+
+#include <vector>
 
 class DocumentState;
 class NbestStorage;
-class Random;
+class SearchStep;
 
 class SimulatedAnnealing : public SearchAlgorithm {
 private:
 	Logger logger_;
-	Random random_;
 	const StateGenerator &generator_;
 	uint totalMaxSteps_;
 	Float targetScore_;
+	uint batchSize_;
+	uint nthreads_;
+	TimeLimit timeLimit_;
 	Parameters parameters_;
 
+	void evaluateStep(
+		const std::vector<SearchStep *> &batch,
+		const std::vector<Float> &draws,
+		Float temperature,
+		Float oldScore,
+		uint k
+	) const;
+
 public:
 	SimulatedAnnealing(const DecoderConfiguration &config, const Parameters &params);
 
 	virtual SearchState *createState(boost::shared_ptr<DocumentState> doc) const;
 	virtual void search(SearchState *sstate, NbestStorage &nbest, uint maxSteps, uint maxAccepted) const;
+
+	virtual void setJobSize(uint documents, uint concurrency) const {
+		timeLimit_.setJobSize(documents, concurrency);
+	}
+
+	virtual void finishDocument() const {
+		timeLimit_.finishDocument();
+	}
+
+	virtual void saveCheckpoint(const SearchState *sstate, boost::archive::binary_oarchive &ar) const;
+	virtual SearchState *loadCheckpoint(boost::shared_ptr<DocumentState> doc, boost::archive::binary_iarchive &ar) const;
 };
 
 #endif
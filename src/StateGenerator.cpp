@@ -51,7 +51,8 @@ struct MonotonicStateInitialiser
 		boost::shared_ptr<const PhrasePairCollection> phraseTranslations,
 		const std::vector<Word> &sentence,
 		int documentNumber,
-		int sentenceNumber
+		int sentenceNumber,
+		Random random
 	) const;
 };
 
@@ -68,7 +69,8 @@ public:
 		boost::shared_ptr<const PhrasePairCollection> phraseTranslations,
 		const std::vector<Word> &sentence,
 		int documentNumber,
-		int sentenceNumber
+		int sentenceNumber,
+		Random random
 	) const;
 };
 
@@ -85,7 +87,8 @@ public:
 		boost::shared_ptr<const PhrasePairCollection> phraseTranslations,
 		const std::vector<Word> &sentence,
 		int documentNumber,
-		int sentenceNumber
+		int sentenceNumber,
+		Random random
 	) const;
 };
 
@@ -95,9 +98,10 @@ MonotonicStateInitialiser::initSegmentation(
 	boost::shared_ptr<const PhrasePairCollection> phraseTranslations,
 	const std::vector<Word> &sentence,
 	int documentNumber,
-	int sentenceNumber
+	int sentenceNumber,
+	Random random
 ) const {
-	return phraseTranslations->proposeSegmentation();
+	return phraseTranslations->proposeSegmentation(random);
 }
 
 
@@ -125,7 +129,8 @@ FileReadStateInitialiser::initSegmentation(
 	boost::shared_ptr<const PhrasePairCollection> phraseTranslations,
 	const std::vector<Word> &sentence,
 	int documentNumber,
-	int sentenceNumber
+	int sentenceNumber,
+	Random random
 ) const {
 	PhraseSegmentation phraseSegmentation = segmentations_[documentNumber][sentenceNumber];
 	//Check that all phrases in the phraseSegmentation exist in phraseTranslations
@@ -158,7 +163,8 @@ NistXmlStateInitialiser::initSegmentation(
 	boost::shared_ptr<const PhrasePairCollection> phraseTranslations,
 	const std::vector<Word> &sentence,
 	int documentNumber,
-	int sentenceNumber
+	int sentenceNumber,
+	Random random
 ) const {
 	if(sentence.empty())
 		return PhraseSegmentation();
@@ -190,19 +196,19 @@ NistXmlStateInitialiser::initSegmentation(
 			boost::token_compress_on
 		);
 		PhraseData srcpd;
-		CoverageBitmap cov(sentence.size());
+		SourceSpan span;
 		try {
 			if(srctokenrange.size() != 2) {
 				BOOST_THROW_EXCEPTION(FileFormatException());
 			}
-			for(uint
-				i = boost::lexical_cast<uint>(srctokenrange.front());
-				i <= boost::lexical_cast<uint>(srctokenrange.back());
-				++i
-			) {
-				srcpd.push_back(sentence[i]);
-				cov.set(i);
+			uint first = boost::lexical_cast<uint>(srctokenrange.front());
+			uint last = boost::lexical_cast<uint>(srctokenrange.back());
+			if(last < first) {
+				BOOST_THROW_EXCEPTION(FileFormatException());
 			}
+			span = SourceSpan(first, last - first + 1);
+			for(uint i = first; i <= last; ++i)
+				srcpd.push_back(sentence[i]);
 		} catch(boost::exception &) {
 			LOG(logger_, error,
 				"Invalid alignment data in raw-translation file "
@@ -216,7 +222,7 @@ NistXmlStateInitialiser::initSegmentation(
 			appit = std::lower_bound(
 				ppvec.begin(),
 				ppvec.end(),
-				CompareAnchoredPhrasePairs::PhrasePairKey(cov, srcpd, tgtpd),
+				CompareAnchoredPhrasePairs::PhrasePairKey(span, srcpd, tgtpd),
 				ppComparator
 			);
 		seg.push_back(*appit);
@@ -228,11 +234,19 @@ NistXmlStateInitialiser::initSegmentation(
 
 StateGenerator::StateGenerator(
 	const std::string &initMethod,
-	const Parameters &params,
-	Random(random)
+	const Parameters &params
 ) :	logger_("StateGenerator"),
-	random_(random)
+	adaptive_(false),
+	adaptationInterval_(0),
+	adaptationDecay_(0),
+	exploration_(0)
 {
+	initThreads_ = params.get<uint>("threads", 1);
+	if(initThreads_ == 0) {
+		LOG(logger_, error, "The initial state needs at least 1 thread.");
+		BOOST_THROW_EXCEPTION(ConfigurationException());
+	}
+
 	if(initMethod == "monotonic")
 		initialiser_ = new MonotonicStateInitialiser(params);
 	else if(initMethod == "testset")
@@ -276,6 +290,126 @@ void StateGenerator::addOperation(
 	cumulativeOperationDistribution_.push_back(weight);
 }
 
+void StateGenerator::setupOperationSelection(
+	const Parameters &params
+) {
+	std::string selection = params.get<std::string>("operation-selection", "static");
+	if(selection == "static") {
+		adaptive_ = false;
+		return;
+	} else if(selection != "adaptive") {
+		LOG(logger_, error, "Unknown operation selection method: " << selection);
+		BOOST_THROW_EXCEPTION(ConfigurationException());
+	}
+
+	adaptive_ = true;
+	adaptationInterval_ = params.get<uint>("adaptation-interval", 1000);
+	adaptationDecay_ = params.get<Float>("adaptation-decay", .5);
+	exploration_ = params.get<Float>("exploration", .1);
+
+	if(adaptationInterval_ == 0) {
+		LOG(logger_, error, "adaptation-interval must be at least 1.");
+		BOOST_THROW_EXCEPTION(ConfigurationException());
+	}
+
+	if(adaptationDecay_ < 0 || adaptationDecay_ > 1) {
+		LOG(logger_, error, "adaptation-decay must be in the interval [0,1].");
+		BOOST_THROW_EXCEPTION(ConfigurationException());
+	}
+
+	// Without exploration, an operation that has failed to improve the
+	// score once would never be tried again.
+	if(exploration_ <= 0 || exploration_ > 1) {
+		LOG(logger_, error, "exploration must be in the interval (0,1].");
+		BOOST_THROW_EXCEPTION(ConfigurationException());
+	}
+}
+
+void StateGenerator::initOperationStatistics(
+	OperationStatistics &stats
+) const {
+	if(!adaptive_)
+		return;
+
+	stats.attempts.assign(operations_.size(), Float(0));
+	stats.gains.assign(operations_.size(), Float(0));
+	stats.cumulativeDistribution = cumulativeOperationDistribution_;
+	stats.stepsSinceUpdate = 0;
+}
+
+uint StateGenerator::getOperationIndex(
+	const StateOperation *op
+) const {
+	for(uint i = 0; i < operations_.size(); i++)
+		if(&operations_[i] == op)
+			return i;
+
+	assert(false);
+	return 0;
+}
+
+void StateGenerator::registerAttempt(
+	OperationStatistics &stats,
+	const StateOperation *op
+) const {
+	if(!adaptive_)
+		return;
+
+	stats.attempts[getOperationIndex(op)]++;
+	if(++stats.stepsSinceUpdate >= adaptationInterval_)
+		updateOperationDistribution(stats);
+}
+
+void StateGenerator::registerGain(
+	OperationStatistics &stats,
+	const StateOperation *op,
+	Float gain
+) const {
+	if(!adaptive_ || gain <= 0)
+		return;
+
+	stats.gains[getOperationIndex(op)] += gain;
+}
+
+/**
+ * Mixes the configured distribution with weight exploration_ and a
+ * distribution proportional to the average gain per attempt of each
+ * operation. Older observations are then discounted by adaptationDecay_.
+ * If no operation has improved the score, the configured distribution
+ * is used.
+ */
+void StateGenerator::updateOperationDistribution(
+	OperationStatistics &stats
+) const {
+	std::vector<Float> rates(operations_.size(), Float(0));
+	Float totalRate = 0;
+	for(uint i = 0; i < operations_.size(); i++) {
+		if(stats.attempts[i] > 0)
+			rates[i] = stats.gains[i] / stats.attempts[i];
+		totalRate += rates[i];
+	}
+
+	Float total = cumulativeOperationDistribution_.back();
+	Float prevStatic = 0;
+	Float cumulative = 0;
+	for(uint i = 0; i < operations_.size(); i++) {
+		Float p = (cumulativeOperationDistribution_[i] - prevStatic) / total;
+		prevStatic = cumulativeOperationDistribution_[i];
+		if(totalRate > 0)
+			p = exploration_ * p + (1 - exploration_) * rates[i] / totalRate;
+		cumulative += p;
+		stats.cumulativeDistribution[i] = cumulative;
+
+		LOG(logger_, debug, operations_[i].getDescription() << ": "
+			<< stats.gains[i] << " / " << stats.attempts[i] << " -> p = " << p);
+
+		stats.attempts[i] *= adaptationDecay_;
+		stats.gains[i] *= adaptationDecay_;
+	}
+
+	stats.stepsSinceUpdate = 0;
+}
+
 /**
  * Returns NULL if 100 consecutive operations have returned NULL.
  */
@@ -284,9 +418,13 @@ SearchStep
 	const DocumentState &doc
 ) const {
 	SearchStep *nextStep = NULL;
+	Random rnd = doc.getRandom();
+	const std::vector<Float> &distribution = adaptive_ ?
+		doc.getOperationStatistics().cumulativeDistribution :
+		cumulativeOperationDistribution_;
 	uint failed = 0;
 	for(;;) {
-		uint next_op = random_.drawFromCumulativeDistribution(cumulativeOperationDistribution_);
+		uint next_op = rnd.drawFromCumulativeDistribution(distribution);
 		LOG(logger_, debug,
 			"Next operation: " << operations_[next_op].getDescription()
 			<< "; failed so far: " << failed
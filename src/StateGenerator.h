@@ -25,6 +25,7 @@
 
 #include "Docent.h"
 #include "DocumentState.h"
+#include "OperationStatistics.h"
 #include "StateOperation.h"
 
 #include <vector>
@@ -38,16 +39,23 @@ class SearchStep;
 class StateGenerator {
 private:
 	Logger logger_;
-	Random random_;
 	boost::ptr_vector<StateOperation> operations_;
 	std::vector<Float> cumulativeOperationDistribution_;
 	StateInitialiser *initialiser_;
+	uint initThreads_;
+
+	bool adaptive_;
+	uint adaptationInterval_;
+	Float adaptationDecay_;
+	Float exploration_;
+
+	uint getOperationIndex(const StateOperation *op) const;
+	void updateOperationDistribution(OperationStatistics &stats) const;
 
 public:
 	StateGenerator(
 		const std::string &initMethod,
-		const Parameters &params,
-		Random random
+		const Parameters &params
 	);
 	~StateGenerator();
 	void addOperation(
@@ -55,18 +63,29 @@ public:
 		const std::string &type,
 		const Parameters &params
 	);
+	void setupOperationSelection(
+		const Parameters &params
+	);
+
+	// number of threads for looking up the phrase translations and creating
+	// the initial segmentations of the sentences of a new document
+	uint getInitialisationThreads() const {
+		return initThreads_;
+	}
 
 	PhraseSegmentation initSegmentation(
 		boost::shared_ptr<const PhrasePairCollection> phraseTranslations,
 		const std::vector<Word> &sentence,
 		int documentNumber,
-		int sentenceNumber
+		int sentenceNumber,
+		Random random
 	) const {
 		return initialiser_->initSegmentation(
 			phraseTranslations,
 			sentence,
 			documentNumber,
-			sentenceNumber
+			sentenceNumber,
+			random
 		);
 	}
 
@@ -78,6 +97,24 @@ public:
 	SearchStep *createSearchStep(
 		const DocumentState &doc
 	) const;
+
+	// With adaptive operation selection, operations are drawn with
+	// probabilities derived from the average score gain per attempt that
+	// each operation recently achieved on the document. These functions
+	// keep the statistics of a document up to date and do nothing if the
+	// operation distribution is static.
+	void initOperationStatistics(
+		OperationStatistics &stats
+	) const;
+	void registerAttempt(
+		OperationStatistics &stats,
+		const StateOperation *op
+	) const;
+	void registerGain(
+		OperationStatistics &stats,
+		const StateOperation *op,
+		Float gain
+	) const;
 };
 
 #endif
@@ -25,19 +25,17 @@
 #include "PhrasePairCollection.h"
 #include "SearchStep.h"
 
-#include <boost/lambda/lambda.hpp>
-#include <boost/lambda/bind.hpp>
 
 SearchStep
 *ChangePhraseTranslationOperation::createSearchStep(
 	const DocumentState &doc
 ) const {
-	const std::vector<PhraseSegmentation>
+	const PhraseSegmentationVector
 		&sentences = doc.getPhraseSegmentations();
 	const std::vector<boost::shared_ptr<const PhrasePairCollection> >
 		&phraseTranslations = getPhraseTranslations(doc);
 
-	Random rnd = doc.getDecoderConfiguration()->getRandom();
+	Random rnd = doc.getRandom();
 
 	uint sentno = doc.drawSentence(rnd);
 	const PhraseSegmentation &sent = sentences[sentno];
@@ -50,7 +48,7 @@ SearchStep
 	for(uint i = 0; i < ph; i++)
 		++it;
 
-	AnchoredPhrasePair pp = pcoll.proposeAlternativeTranslation(*it);
+	AnchoredPhrasePair pp = pcoll.proposeAlternativeTranslation(*it, rnd);
 
 	if(*it == pp)
 		return NULL;
@@ -80,11 +78,11 @@ SearchStep
 *PermutePhrasesOperation::createSearchStep(
 	const DocumentState &doc
 ) const {
-	const std::vector<PhraseSegmentation>
+	const PhraseSegmentationVector
 		&sentences = doc.getPhraseSegmentations();
 
 	LOG(logger_, verbose, "permutePhrases");
-	Random rnd = doc.getDecoderConfiguration()->getRandom();
+	Random rnd = doc.getRandom();
 
 	uint sentno;
 	uint sentsize;
@@ -153,11 +151,11 @@ SearchStep
 *LinearisePhrasesOperation::createSearchStep(
 	const DocumentState &doc
 ) const {
-	const std::vector<PhraseSegmentation>
+	const PhraseSegmentationVector
 		&sentences = doc.getPhraseSegmentations();
 
 	LOG(logger_, verbose, "linearisePhrases");
-	Random rnd = doc.getDecoderConfiguration()->getRandom();
+	Random rnd = doc.getRandom();
 
 	uint sentno;
 	uint sentsize;
@@ -234,11 +232,11 @@ SearchStep
 *SwapPhrasesOperation::createSearchStep(
 	const DocumentState &doc
 ) const {
-	const std::vector<PhraseSegmentation>
+	const PhraseSegmentationVector
 		&sentences = doc.getPhraseSegmentations();
 
 	LOG(logger_, verbose, "swapPhrases");
-	Random rnd = doc.getDecoderConfiguration()->getRandom();
+	Random rnd = doc.getRandom();
 
 	uint sentno;
 	uint sentsize;
@@ -329,11 +327,11 @@ SearchStep
 *MovePhrasesOperation::createSearchStep(
 	const DocumentState &doc
 ) const {
-	const std::vector<PhraseSegmentation>
+	const PhraseSegmentationVector
 		&sentences = doc.getPhraseSegmentations();
 
 	LOG(logger_, verbose, "movePhrases");
-	Random rnd = doc.getDecoderConfiguration()->getRandom();
+	Random rnd = doc.getRandom();
 
 	uint sentno;
 	uint sentsize;
@@ -412,14 +410,13 @@ ResegmentOperation::ResegmentOperation(
 
 SearchStep
 *ResegmentOperation::createSearchStep(const DocumentState &doc) const {
-	const std::vector<PhraseSegmentation>
+	const PhraseSegmentationVector
 		&sentences = doc.getPhraseSegmentations();
 	const std::vector<boost::shared_ptr<const PhrasePairCollection> >
 		&phraseTranslations = getPhraseTranslations(doc);
-	using namespace boost::lambda;
 
 	LOG(logger_, verbose, "resegment");
-	Random rnd = doc.getDecoderConfiguration()->getRandom();
+	Random rnd = doc.getRandom();
 
 	uint sentno = doc.drawSentence(rnd);
 	const PhraseSegmentation &sent = sentences[sentno];
@@ -437,14 +434,12 @@ SearchStep
 		++oe;
 
 	CoverageBitmap tgt(pcoll.getSentenceLength());
-	std::for_each(
-		os, oe,
-		tgt |= boost::lambda::bind<const CoverageBitmap &>(&AnchoredPhrasePair::first, _1)
-	);
+	for(PhraseSegmentation::const_iterator it = os; it != oe; ++it)
+		tgt.set(it->first.start, it->first.length, true);
 
 	LOG(logger_, debug, "Resegmenting " << tgt);
 
-	PhraseSegmentation newseg = pcoll.proposeSegmentation(tgt);
+	PhraseSegmentation newseg = pcoll.proposeSegmentation(tgt, rnd);
 
 	std::pair<
 		PhraseSegmentation::const_iterator,
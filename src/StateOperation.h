@@ -75,7 +75,8 @@ struct StateInitialiser {
 		boost::shared_ptr<const PhrasePairCollection> phraseTranslations,
 		const std::vector<Word> &sentence,
 		int documentNumber,
-		int sentenceNumber
+		int sentenceNumber,
+		Random random
 	) const = 0;
 };
 
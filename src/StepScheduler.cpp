@@ -0,0 +1,167 @@
+/*
+ *  StepScheduler.cpp
+ *
+ *  Copyright 2012 by Christian Hardmeier. All rights reserved.
+ *
+ *  This file is part of Docent, a document-level decoder for phrase-based
+ *  statistical machine translation.
+ *
+ *  Docent is free software: you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation, either version 3 of the License, or (at your option) any later
+ *  version.
+ *
+ *  Docent is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  Docent. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StepScheduler.h"
+
+#include "DocumentState.h"
+#include "SearchAlgorithm.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <ctime>
+#include <limits>
+
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+
+StepScheduler::StepScheduler(
+	const SearchAlgorithm &algorithm,
+	uint sliceSteps,
+	uint nthreads
+) :	logger_("StepScheduler"),
+	algorithm_(algorithm),
+	sliceSteps_(sliceSteps)
+{
+	if(nthreads > 1)
+		workers_.reset(new WorkerPool(nthreads));
+}
+
+StepScheduler::~StepScheduler()
+{
+	BOOST_FOREACH(Document &d, documents_)
+		delete d.state;
+}
+
+void StepScheduler::addDocument(
+	const boost::shared_ptr<DocumentState> &doc
+) {
+	documents_.push_back(Document(algorithm_.createState(doc), doc->getScore()));
+}
+
+// Runs in the worker threads. Each call only touches its own document.
+void StepScheduler::runSlice(
+	const std::vector<uint> &docs,
+	uint steps,
+	uint k
+) {
+	Document &d = documents_[docs[k]];
+	uint before = d.state->getNumberOfSteps();
+	algorithm_.search(d.state, d.nbest, steps, std::numeric_limits<uint>::max());
+	uint done = d.state->getNumberOfSteps() - before;
+
+	if(steps > 0 && done == 0) {
+		d.finished = true;
+		algorithm_.finishDocument();
+		return;
+	}
+
+	// The rate is smoothed over the recent slices so a single slice
+	// without improvement doesn't put a document at the end of the queue.
+	Float rate = 0;
+	if(done > 0 && d.nbest.getBestScore() > d.bestScore)
+		rate = (d.nbest.getBestScore() - d.bestScore) / done;
+	d.improvementRate = .5 * d.improvementRate + .5 * rate;
+	d.bestScore = std::max(d.bestScore, d.nbest.getBestScore());
+}
+
+void StepScheduler::runSlices(
+	const std::vector<uint> &docs,
+	uint steps,
+	uint &stepsDone
+) {
+	std::vector<uint> before;
+	BOOST_FOREACH(uint i, docs)
+		before.push_back(documents_[i].state->getNumberOfSteps());
+
+	if(workers_)
+		workers_->run(docs.size(), boost::bind(&StepScheduler::runSlice, this,
+			boost::cref(docs), steps, _1));
+	else
+		for(uint k = 0; k < docs.size(); k++)
+			runSlice(docs, steps, k);
+
+	for(uint k = 0; k < docs.size(); k++)
+		stepsDone += documents_[docs[k]].state->getNumberOfSteps() - before[k];
+}
+
+bool StepScheduler::compareDocuments(
+	uint a,
+	uint b
+) const {
+	const Document &da = documents_[a];
+	const Document &db = documents_[b];
+	if(da.improvementRate != db.improvementRate)
+		return da.improvementRate > db.improvementRate;
+	else
+		return da.state->getNumberOfSteps() < db.state->getNumberOfSteps();
+}
+
+void StepScheduler::run(
+	uint stepBudget,
+	Float cpuBudget
+) {
+	std::clock_t start = std::clock();
+	uint stepsDone = 0;
+	uint nthreads = workers_ ? workers_->getNumberOfThreads() : 1;
+
+	// every document gets one slice to start with
+	std::vector<uint> all;
+	for(uint i = 0; i < documents_.size(); i++)
+		all.push_back(i);
+	if(!all.empty())
+		runSlices(all, std::min(sliceSteps_, stepBudget / uint(all.size())), stepsDone);
+
+	for(;;) {
+		if(stepsDone >= stepBudget) {
+			LOG(logger_, normal, "Step budget of " << stepBudget << " steps used up.");
+			break;
+		}
+
+		Float cpuTime = Float(std::clock() - start) / CLOCKS_PER_SEC;
+		if(cpuTime >= cpuBudget) {
+			LOG(logger_, normal, "CPU time budget of " << cpuBudget << " seconds used up.");
+			break;
+		}
+
+		std::vector<uint> active;
+		for(uint i = 0; i < documents_.size(); i++)
+			if(!documents_[i].finished)
+				active.push_back(i);
+		if(active.empty()) {
+			LOG(logger_, normal, "All documents finished.");
+			break;
+		}
+
+		std::sort(active.begin(), active.end(),
+			boost::bind(&StepScheduler::compareDocuments, this, _1, _2));
+		if(active.size() > nthreads)
+			active.resize(nthreads);
+
+		uint steps = std::min(sliceSteps_, (stepBudget - stepsDone) / uint(active.size()));
+		runSlices(active, std::max(steps, 1u), stepsDone);
+	}
+
+	for(uint i = 0; i < documents_.size(); i++)
+		LOG(logger_, normal, "Document " << i << ": "
+			<< documents_[i].state->getNumberOfSteps() << " steps, best score "
+			<< documents_[i].bestScore);
+}
@@ -0,0 +1,90 @@
+/*
+ *  StepScheduler.h
+ *
+ *  Copyright 2012 by Christian Hardmeier. All rights reserved.
+ *
+ *  This file is part of Docent, a document-level decoder for phrase-based
+ *  statistical machine translation.
+ *
+ *  Docent is free software: you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation, either version 3 of the License, or (at your option) any later
+ *  version.
+ *
+ *  Docent is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  Docent. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef docent_StepScheduler_h
+#define docent_StepScheduler_h
+
+#include "Docent.h"
+#include "NbestStorage.h"
+
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+class DocumentState;
+struct SearchAlgorithm;
+struct SearchState;
+class WorkerPool;
+
+/**
+ * Distributes a search budget for a whole test set among its documents.
+ * The documents are searched in slices of a fixed number of steps. After
+ * every document has had one slice, the next slices go to the documents
+ * whose best score has recently improved fastest per step, so documents
+ * that have converged stop consuming steps that harder documents can use.
+ * A document is retired when the search algorithm stops making steps on
+ * it, e.g. because its max-steps limit or the end of the cooling schedule
+ * has been reached. With several threads, the slices of different
+ * documents are searched in parallel.
+ */
+class StepScheduler : private boost::noncopyable {
+private:
+	struct Document {
+		SearchState *state;
+		NbestStorage nbest;
+		Float bestScore;
+		Float improvementRate;
+		bool finished;
+
+		Document(SearchState *s, Float score) :
+			state(s), nbest(1), bestScore(score), improvementRate(0), finished(false) {}
+	};
+
+	Logger logger_;
+	const SearchAlgorithm &algorithm_;
+	uint sliceSteps_;
+	boost::scoped_ptr<WorkerPool> workers_;
+	std::vector<Document> documents_;
+
+	void runSlices(const std::vector<uint> &docs, uint steps, uint &stepsDone);
+	void runSlice(const std::vector<uint> &docs, uint steps, uint k);
+	bool compareDocuments(uint a, uint b) const;
+
+public:
+	StepScheduler(const SearchAlgorithm &algorithm, uint sliceSteps, uint nthreads);
+	~StepScheduler();
+
+	void addDocument(const boost::shared_ptr<DocumentState> &doc);
+
+	// Runs until stepBudget steps have been done in total, cpuBudget seconds
+	// of processor time have been used, or all documents are finished. The
+	// processor time is that of the whole process, summed over all threads.
+	void run(uint stepBudget, Float cpuBudget);
+
+	const DocumentState &getBestDocumentState(uint doc) const {
+		return *documents_[doc].nbest.getBestDocumentState();
+	}
+};
+
+#endif
@@ -0,0 +1,74 @@
+/*
+ *  TimeLimit.cpp
+ *
+ *  Copyright 2012 by Christian Hardmeier. All rights reserved.
+ *
+ *  This file is part of Docent, a document-level decoder for phrase-based
+ *  statistical machine translation.
+ *
+ *  Docent is free software: you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation, either version 3 of the License, or (at your option) any later
+ *  version.
+ *
+ *  Docent is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  Docent. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TimeLimit.h"
+
+#include "DecoderConfiguration.h"
+
+#include <algorithm>
+#include <limits>
+
+const uint TimeLimit::checkInterval;
+
+TimeLimit::TimeLimit(
+	const Parameters &params
+) :	maxDocumentTime_(params.get<Float>("max-time", 0)),
+	documentsLeft_(0),
+	concurrency_(1)
+{
+	Float maxJobTime = params.get<Float>("max-job-time", 0);
+	if(maxJobTime > 0)
+		jobDeadline_ = now() + boost::posix_time::microseconds(
+			static_cast<boost::int64_t>(maxJobTime * 1e6));
+}
+
+void TimeLimit::setJobSize(
+	uint documents,
+	uint concurrency
+) const {
+	boost::mutex::scoped_lock lock(jobMutex_);
+	documentsLeft_ = documents;
+	concurrency_ = std::max(concurrency, 1u);
+}
+
+void TimeLimit::finishDocument() const {
+	boost::mutex::scoped_lock lock(jobMutex_);
+	if(documentsLeft_ > 0)
+		documentsLeft_--;
+}
+
+Float TimeLimit::getRemainingTime(
+	Float used,
+	const TimePoint &now
+) const {
+	Float remaining = std::numeric_limits<Float>::infinity();
+	if(maxDocumentTime_ > 0)
+		remaining = maxDocumentTime_ - used;
+	if(!jobDeadline_.is_not_a_date_time()) {
+		Float jobRemaining = secondsBetween(now, jobDeadline_);
+		boost::mutex::scoped_lock lock(jobMutex_);
+		if(documentsLeft_ > concurrency_)
+			jobRemaining = jobRemaining * concurrency_ / documentsLeft_;
+		remaining = std::min(remaining, jobRemaining);
+	}
+	return remaining;
+}
@@ -0,0 +1,85 @@
+/*
+ *  TimeLimit.h
+ *
+ *  Copyright 2012 by Christian Hardmeier. All rights reserved.
+ *
+ *  This file is part of Docent, a document-level decoder for phrase-based
+ *  statistical machine translation.
+ *
+ *  Docent is free software: you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation, either version 3 of the License, or (at your option) any later
+ *  version.
+ *
+ *  Docent is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  Docent. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef docent_TimeLimit_h
+#define docent_TimeLimit_h
+
+#include "Docent.h"
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/thread/mutex.hpp>
+
+class Parameters;
+
+/**
+ * Wall-clock time limits of a search algorithm, read from the search
+ * parameters "max-time" (seconds of search per document) and "max-job-time"
+ * (seconds from the creation of the search algorithm, i.e. from loading
+ * the configuration, to the end of the whole job). Both are optional.
+ * The time left in the job is shared out evenly among the documents not
+ * finished yet, of which the frontend can tell that some are searched
+ * concurrently; without this information, a document may use all of it.
+ * Reading the clock is cheap, but not free, so searches only check the
+ * time every checkInterval steps.
+ */
+class TimeLimit {
+private:
+	Float maxDocumentTime_;
+	boost::posix_time::ptime jobDeadline_;
+
+	// Job progress, updated by the frontend and by all search threads.
+	mutable boost::mutex jobMutex_;
+	mutable uint documentsLeft_;
+	mutable uint concurrency_;
+
+public:
+	typedef boost::posix_time::ptime TimePoint;
+
+	static const uint checkInterval = 16;
+
+	TimeLimit(const Parameters &params);
+
+	bool isLimited() const {
+		return maxDocumentTime_ > 0 || !jobDeadline_.is_not_a_date_time();
+	}
+
+	static TimePoint now() {
+		return boost::posix_time::microsec_clock::universal_time();
+	}
+
+	static Float secondsBetween(const TimePoint &from, const TimePoint &to) {
+		return (to - from).total_microseconds() * Float(1e-6);
+	}
+
+	// The job consists of documents documents, up to concurrency of
+	// which are searched at the same time.
+	void setJobSize(uint documents, uint concurrency) const;
+
+	void finishDocument() const;
+
+	// Time left at time point now for a document that has been searched
+	// for used seconds, including its share of the time left in the job;
+	// may be negative.
+	Float getRemainingTime(Float used, const TimePoint &now) const;
+};
+
+#endif
@@ -0,0 +1,70 @@
+/*
+ *  Vocabulary.cpp
+ *
+ *  Copyright 2012 by Christian Hardmeier. All rights reserved.
+ *
+ *  This file is part of Docent, a document-level decoder for phrase-based
+ *  statistical machine translation.
+ *
+ *  Docent is free software: you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation, either version 3 of the License, or (at your option) any later
+ *  version.
+ *
+ *  Docent is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  Docent. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Vocabulary.h"
+
+#include <boost/foreach.hpp>
+
+Vocabulary::IndexMap_ Vocabulary::index_;
+std::deque<Word> Vocabulary::words_;
+boost::mutex Vocabulary::mutex_;
+boost::thread_specific_ptr<Vocabulary::IndexMap_> Vocabulary::threadIndex_;
+
+WordId Vocabulary::getId(const Word &word) {
+	IndexMap_ *threadIndex = threadIndex_.get();
+	if(threadIndex == NULL) {
+		threadIndex = new IndexMap_();
+		threadIndex_.reset(threadIndex);
+	} else {
+		IndexMap_::const_iterator it = threadIndex->find(word);
+		if(it != threadIndex->end())
+			return it->second;
+	}
+
+	boost::mutex::scoped_lock lock(mutex_);
+
+	WordId id;
+
+	IndexMap_::const_iterator it = index_.find(word);
+	if(it == index_.end()) {
+		id = words_.size();
+		words_.push_back(word);
+		index_.insert(std::make_pair(word, id));
+	} else
+		id = it->second;
+
+	threadIndex->insert(std::make_pair(word, id));
+	return id;
+}
+
+std::vector<WordId> Vocabulary::getIds(const std::vector<Word> &words) {
+	std::vector<WordId> ids;
+	ids.reserve(words.size());
+	BOOST_FOREACH(const Word &w, words)
+		ids.push_back(getId(w));
+	return ids;
+}
+
+Word Vocabulary::getWord(WordId id) {
+	boost::mutex::scoped_lock lock(mutex_);
+	return words_[id];
+}
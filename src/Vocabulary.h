@@ -0,0 +1,56 @@
+/*
+ *  Vocabulary.h
+ *
+ *  Copyright 2012 by Christian Hardmeier. All rights reserved.
+ *
+ *  This file is part of Docent, a document-level decoder for phrase-based
+ *  statistical machine translation.
+ *
+ *  Docent is free software: you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation, either version 3 of the License, or (at your option) any later
+ *  version.
+ *
+ *  Docent is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  Docent. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef docent_Vocabulary_h
+#define docent_Vocabulary_h
+
+#include "Docent.h"
+
+#include <deque>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+#include <boost/unordered_map.hpp>
+
+// Dense integer identifier of a word, valid for the lifetime of the process.
+typedef uint WordId;
+
+// Process-wide interned vocabulary, so that models can count and compare
+// words as integers instead of hashing strings in every search step.
+class Vocabulary {
+private:
+	typedef boost::unordered_map<Word,WordId> IndexMap_;
+	static IndexMap_ index_;
+	static std::deque<Word> words_;
+	static boost::mutex mutex_;
+	// Each thread keeps a copy of the part of the index it has used to
+	// avoid taking the lock for known words.
+	static boost::thread_specific_ptr<IndexMap_> threadIndex_;
+
+public:
+	static WordId getId(const Word &word);
+	static std::vector<WordId> getIds(const std::vector<Word> &words);
+	static Word getWord(WordId id);
+};
+
+#endif
@@ -0,0 +1,101 @@
+/*
+ *  WorkerPool.cpp
+ *
+ *  Copyright 2012 by Christian Hardmeier. All rights reserved.
+ *
+ *  This file is part of Docent, a document-level decoder for phrase-based
+ *  statistical machine translation.
+ *
+ *  Docent is free software: you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation, either version 3 of the License, or (at your option) any later
+ *  version.
+ *
+ *  Docent is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  Docent. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+#include <boost/bind.hpp>
+
+WorkerPool::WorkerPool(
+	uint nthreads
+) :	nthreads_(std::max(nthreads, 1u)),
+	round_(0),
+	n_(0),
+	next_(0),
+	busy_(0),
+	shutdown_(false)
+{
+	for(uint i = 1; i < nthreads_; i++)
+		threads_.create_thread(boost::bind(&WorkerPool::workerLoop, this));
+}
+
+WorkerPool::~WorkerPool() {
+	{
+		boost::mutex::scoped_lock lock(mutex_);
+		shutdown_ = true;
+	}
+	jobAvailable_.notify_all();
+	threads_.join_all();
+}
+
+void WorkerPool::run(uint n, const Job_ &f) {
+	boost::mutex::scoped_lock lock(mutex_);
+	job_ = f;
+	n_ = n;
+	next_ = 0;
+	error_ = boost::exception_ptr();
+	round_++;
+	jobAvailable_.notify_all();
+
+	processJob(lock);
+
+	while(busy_ > 0)
+		jobDone_.wait(lock);
+
+	job_.clear();
+	if(error_)
+		boost::rethrow_exception(error_);
+}
+
+void WorkerPool::workerLoop() {
+	boost::mutex::scoped_lock lock(mutex_);
+	uint seen = round_;
+	for(;;) {
+		while(!shutdown_ && round_ == seen)
+			jobAvailable_.wait(lock);
+		if(shutdown_)
+			return;
+		seen = round_;
+		processJob(lock);
+		if(busy_ == 0)
+			jobDone_.notify_all();
+	}
+}
+
+// Called and returns with the lock held, but releases it while calling the job.
+void WorkerPool::processJob(boost::mutex::scoped_lock &lock) {
+	while(!error_ && next_ < n_) {
+		uint i = next_++;
+		busy_++;
+		lock.unlock();
+		try {
+			job_(i);
+			lock.lock();
+		} catch(...) {
+			lock.lock();
+			if(!error_)
+				error_ = boost::current_exception();
+		}
+		busy_--;
+	}
+}
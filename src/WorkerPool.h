@@ -0,0 +1,76 @@
+/*
+ *  WorkerPool.h
+ *
+ *  Copyright 2012 by Christian Hardmeier. All rights reserved.
+ *
+ *  This file is part of Docent, a document-level decoder for phrase-based
+ *  statistical machine translation.
+ *
+ *  Docent is free software: you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation, either version 3 of the License, or (at your option) any later
+ *  version.
+ *
+ *  Docent is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  Docent. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef docent_WorkerPool_h
+#define docent_WorkerPool_h
+
+#include "Docent.h"
+
+#include <boost/exception_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+/**
+ * A set of threads kept alive between jobs. Unlike parallelFor, which starts
+ * and joins its threads for every call, a WorkerPool is meant for small jobs
+ * that are run many times in a row, such as the evaluation of a batch of
+ * search steps. The calling thread takes part in every job, so a pool created
+ * for n threads starts n-1 threads of its own.
+ */
+class WorkerPool : private boost::noncopyable {
+private:
+	typedef boost::function<void(uint)> Job_;
+
+	boost::thread_group threads_;
+	boost::mutex mutex_;
+	boost::condition_variable jobAvailable_;
+	boost::condition_variable jobDone_;
+
+	uint nthreads_;
+	Job_ job_;
+	uint round_;
+	uint n_;
+	uint next_;
+	uint busy_;
+	bool shutdown_;
+	boost::exception_ptr error_;
+
+	void workerLoop();
+	void processJob(boost::mutex::scoped_lock &lock);
+
+public:
+	WorkerPool(uint nthreads);
+	~WorkerPool();
+
+	uint getNumberOfThreads() const {
+		return nthreads_;
+	}
+
+	// Calls f(i) for i = 0, ..., n-1 and waits for all calls to complete.
+	// If a call throws an exception, the first exception is rethrown here.
+	void run(uint n, const Job_ &f);
+};
+
+#endif
@@ -255,7 +255,8 @@ void processTestset(
 		if (!firstStateFilename.empty()) {
 			std::vector<std::vector<PhraseSegmentation> > state;
 			for(uint i = 0; i < states.size(); i++) {
-				state.push_back(states[i]->getLastDocumentState()->getPhraseSegmentations());
+				const PhraseSegmentationVector &segs = states[i]->getLastDocumentState()->getPhraseSegmentations();
+				state.push_back(std::vector<PhraseSegmentation>(segs.begin(), segs.end()));
 			}
 			printState(firstStateFilename, state);
 		}
@@ -318,7 +319,8 @@ void processTestset(
 			std::vector<std::vector<PhraseSegmentation> > state;
 			for(uint i = 0; i < nbest.size(); i++) {
 				//std::cerr << "getting state for final printing, sentence " << i << std::endl;
-				state.push_back(nbest[i].getBestDocumentState()->getPhraseSegmentations());
+				const PhraseSegmentationVector &segs = nbest[i].getBestDocumentState()->getPhraseSegmentations();
+				state.push_back(std::vector<PhraseSegmentation>(segs.begin(), segs.end()));
 			}
 			printState(lastStateFilename, state);
 		}
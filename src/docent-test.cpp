@@ -21,35 +21,245 @@
  */
 
 #include <algorithm>
+#include <cmath>
 #include <functional>
 #include <iostream>
 #include <iterator>
+#include <limits>
+#include <sstream>
 #include <vector>
 
 #include <boost/algorithm/string.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
 #include <boost/foreach.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/lambda/lambda.hpp>
 
 #include "Docent.h"
 #include "DecoderConfiguration.h"
 #include "DocumentState.h"
+#include "FeatureFunction.h"
 #include "MMAXDocument.h"
 #include "NbestStorage.h"
+#include "Random.h"
 #include "SearchAlgorithm.h"
+#include "models/WellFormednessModel.h"
 
 void usage() {
 	std::cerr << "Usage: cat test.txt |"
-		" docent-test [-d moduleToDebug] config.xml"
+		" docent-test [-d moduleToDebug] [--check-scores | --check-checkpoint] config.xml\n"
+		"       docent-test --check-streams\n"
+		"       docent-test --check-tags"
 		<< std::endl;
 	exit(1);
 }
 
+static std::vector<uint> drawSequence(const Random &stream, uint length) {
+	std::vector<uint> draws;
+	draws.reserve(length);
+	for(uint i = 0; i < length; i++)
+		draws.push_back(stream.drawFromRange(1u << 30));
+	return draws;
+}
+
+// The replica streams of parallel tempering and the sentence initialisation
+// streams are derived from the same document stream, so make sure they don't
+// replay each other's draws, not even from the second draw on.
+static bool checkStreamSeparation() {
+	const uint nstreams = 8;
+	const uint length = 16;
+	Random random = Random::create();
+	random.seed(4711);
+	for(uint docNum = 0; docNum < 4; docNum++) {
+		Random doc = random.createStream(docNum);
+		std::vector<std::vector<uint> > draws;
+		for(uint i = 0; i < nstreams; i++) {
+			draws.push_back(drawSequence(doc.createStream(Random::ReplicaStream, i), length));
+			draws.push_back(drawSequence(doc.createStream(Random::SentenceInitialisationStream, i), length));
+		}
+		for(uint i = 0; i < draws.size(); i++)
+			for(uint j = i + 1; j < draws.size(); j++)
+				for(uint k = 0; k < length; k++)
+					if(draws[i][k] == draws[j][k]) {
+						std::cerr << "Streams " << i << " and " << j << " of document " << docNum
+							<< " have the same draw at position " << k << '.' << std::endl;
+						return false;
+					}
+	}
+	std::cerr << "Random streams are separate." << std::endl;
+	return true;
+}
+
+// The conflict count of the well-formedness model as it was computed before
+// the model kept per-sentence summaries: one scan over all tags.
+static uint countTagConflictsByScan(const std::vector<std::vector<std::string> > &sentenceTags) {
+	std::vector<std::string> tags;
+	uint conflictCount = 0;
+	BOOST_FOREACH(const std::vector<std::string> &st, sentenceTags)
+		BOOST_FOREACH(const std::string &t, st) {
+			if(t[0] != '/')
+				tags.push_back(t);
+			else if(tags.empty() || tags.back() != t.substr(1))
+				conflictCount++; // a mismatched closing tag doesn't pop
+			else
+				tags.pop_back();
+		}
+	return conflictCount + tags.size();
+}
+
+// The summaries must give exactly the conflict count of the full scan,
+// including closing tags that don't match and closing tags that meet an
+// empty stack within their sentence and are matched by an earlier sentence.
+static bool checkTagSummaries() {
+	const char *names[] = { "a", "b", "c" };
+	Random random = Random::create();
+	random.seed(4711);
+	for(uint n = 0; n < 10000; n++) {
+		std::vector<std::vector<std::string> > doc(random.drawFromRange(8) + 1);
+		BOOST_FOREACH(std::vector<std::string> &st, doc) {
+			uint ntags = random.drawFromRange(6);
+			for(uint i = 0; i < ntags; i++)
+				st.push_back((random.flipCoin() ? "/" : "") + std::string(names[random.drawFromRange(3)]));
+		}
+		uint summarised = WellFormednessModel::countTagConflicts(doc);
+		uint scanned = countTagConflictsByScan(doc);
+		if(summarised != scanned) {
+			std::cerr << "Tag summaries give " << summarised << " conflicts instead of "
+				<< scanned << " for:";
+			BOOST_FOREACH(const std::vector<std::string> &st, doc) {
+				BOOST_FOREACH(const std::string &t, st)
+					std::cerr << ' ' << t;
+				std::cerr << " -";
+			}
+			std::cerr << std::endl;
+			return false;
+		}
+	}
+	std::cerr << "Tag summaries agree with the full scan." << std::endl;
+	return true;
+}
+
+static bool sameScore(Float a, Float b) {
+	return std::abs(a - b) <= Float(1e-4) * std::max(Float(1), std::abs(b));
+}
+
+static bool sameScores(const Scores &a, const Scores &b) {
+	for(uint i = 0; i < a.size(); i++)
+		if(!sameScore(a[i], b[i]))
+			return false;
+	return true;
+}
+
+// The scores a search arrives at are updated step by step through the state
+// modifications of each model. They must match the scores computed from
+// scratch for the same translation.
+static bool checkScores(const DocumentState &doc) {
+	DocumentState fresh(doc, doc.getPhraseSegmentations(), doc.getGeneration());
+	const Scores &updated = doc.getScores();
+	const Scores &exact = fresh.getScores();
+	bool ok = true;
+	for(uint i = 0; i < exact.size(); i++)
+		if(!sameScore(updated[i], exact[i])) {
+			std::cerr << "Score " << i << " of document " << doc.getDocNumber() << " is "
+				<< updated[i] << " after search, but " << exact[i] << " computed from scratch." << std::endl;
+			ok = false;
+		}
+	return ok;
+}
+
+// A search that is checkpointed halfway and resumed from the checkpoint must
+// end where a search without the checkpoint ends: the random number streams,
+// the cooling schedule, the step counters and the n-best list all have to be
+// restored. Both searches are run in two slices like in lcurve-docent, since
+// a batch of proposals doesn't reach across the end of a slice. Scores are
+// recomputed when a checkpoint is loaded, so they are only compared up to
+// rounding.
+static bool checkCheckpoint(
+	const DecoderConfiguration &config,
+	const boost::shared_ptr<const MMAXDocument> &mmax,
+	uint docNum
+) {
+	const uint halfSteps = 1000;
+	const uint nbestSize = 1;
+	const SearchAlgorithm &algo = config.getSearchAlgorithm();
+
+	boost::scoped_ptr<SearchState> straight(
+		algo.createState(boost::make_shared<DocumentState>(config, mmax, docNum)));
+	NbestStorage straightNbest(nbestSize);
+	for(uint i = 0; i < 2; i++)
+		algo.search(straight.get(), straightNbest, halfSteps, std::numeric_limits<uint>::max());
+
+	std::ostringstream checkpoint;
+	{
+		boost::scoped_ptr<SearchState> first(
+			algo.createState(boost::make_shared<DocumentState>(config, mmax, docNum)));
+		NbestStorage firstNbest(nbestSize);
+		algo.search(first.get(), firstNbest, halfSteps, std::numeric_limits<uint>::max());
+
+		boost::archive::binary_oarchive oa(checkpoint);
+		first->getLastDocumentState()->saveCheckpoint(oa);
+		algo.saveCheckpoint(first.get(), oa);
+		firstNbest.saveCheckpoint(oa);
+	}
+
+	std::istringstream is(checkpoint.str());
+	boost::archive::binary_iarchive ia(is);
+	boost::shared_ptr<DocumentState> restored(new DocumentState(config, mmax, docNum, ia));
+	boost::scoped_ptr<SearchState> resumed(algo.loadCheckpoint(restored, ia));
+	NbestStorage resumedNbest(nbestSize);
+	resumedNbest.loadCheckpoint(ia, *restored);
+	algo.search(resumed.get(), resumedNbest, halfSteps, std::numeric_limits<uint>::max());
+
+	bool ok = true;
+	const DocumentState &a = *straight->getLastDocumentState();
+	const DocumentState &b = *resumed->getLastDocumentState();
+	if(!(a == b)) {
+		std::cerr << "Document " << docNum << ": resumed search ends in a different translation." << std::endl;
+		ok = false;
+	} else if(!sameScores(a.getScores(), b.getScores())) {
+		std::cerr << "Document " << docNum << ": resumed search ends with different scores." << std::endl;
+		ok = false;
+	}
+	if(straight->getNumberOfSteps() != resumed->getNumberOfSteps()) {
+		std::cerr << "Document " << docNum << ": " << straight->getNumberOfSteps() << " steps in the straight search, "
+			<< resumed->getNumberOfSteps() << " in the resumed search." << std::endl;
+		ok = false;
+	}
+
+	std::vector<boost::shared_ptr<const DocumentState> > straightList, resumedList;
+	straightNbest.copyNbestList(straightList);
+	resumedNbest.copyNbestList(resumedList);
+	bool sameNbest = straightList.size() == resumedList.size();
+	for(uint i = 0; sameNbest && i < straightList.size(); i++)
+		sameNbest = *straightList[i] == *resumedList[i]
+			&& sameScores(straightList[i]->getScores(), resumedList[i]->getScores());
+	if(!sameNbest) {
+		std::cerr << "Document " << docNum << ": resumed search has a different n-best list." << std::endl;
+		ok = false;
+	}
+
+	if(ok)
+		std::cerr << "Document " << docNum << ": resumed search matches the straight search." << std::endl;
+	return ok;
+}
+
 int main(int argc, char **argv)
 {
 	std::string configFile;
+	bool scoreCheck = false;
+	bool checkpointCheck = false;
 	for(int i = 1; i < argc; i++) {
-		if(!strcmp(argv[i], "-d")) {
+		if(!strcmp(argv[i], "--check-streams")) {
+			return checkStreamSeparation() ? 0 : 1;
+		} else if(!strcmp(argv[i], "--check-tags")) {
+			return checkTagSummaries() ? 0 : 1;
+		} else if(!strcmp(argv[i], "--check-scores")) {
+			scoreCheck = true;
+		} else if(!strcmp(argv[i], "--check-checkpoint")) {
+			checkpointCheck = true;
+		} else if(!strcmp(argv[i], "-d")) {
 			if(i >= argc - 1)
 				usage();
 			Logger::setLogLevel(argv[++i], debug);
@@ -65,6 +275,7 @@ int main(int argc, char **argv)
 
 	std::string line;
 	uint docNum = 0;
+	bool checksOk = true;
 	while(getline(std::cin, line)) {
 		std::vector<Word> tokens;
 		boost::split(tokens, line, boost::is_any_of(" "));
@@ -73,6 +284,13 @@ int main(int argc, char **argv)
 			boost::make_shared<MMAXDocument>();
 		mmax->addSentence(tokens.begin(), tokens.end());
 
+		if(checkpointCheck) {
+			if(!checkCheckpoint(config, mmax, docNum))
+				checksOk = false;
+			docNum++;
+			continue;
+		}
+
 		boost::shared_ptr<DocumentState> doc =
 			boost::make_shared<DocumentState>(config, mmax, docNum);
 		NbestStorage nbest(5);
@@ -84,6 +302,9 @@ int main(int argc, char **argv)
 		std::cout << "Final state:" << std::endl;
 		std::cout << *doc << "\n\n" << std::endl;
 
+		if(scoreCheck && !checkScores(*doc))
+			checksOk = false;
+
 		std::vector<boost::shared_ptr<const DocumentState> > nbestList;
 		nbest.copyNbestList(nbestList);
 		std::cout << "N-best list size: " << nbestList.size() << std::endl;
@@ -95,5 +316,5 @@ int main(int argc, char **argv)
 		);
 		docNum++;
 	}
-	return 0;
+	return checksOk ? 0 : 1;
 }
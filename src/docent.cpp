@@ -23,10 +23,14 @@
 #include <algorithm>
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <vector>
 
+#include <boost/bind.hpp>
 #include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include "Docent.h"
 #include "DecoderConfiguration.h"
@@ -34,10 +38,15 @@
 #include "MMAXTestset.h"
 #include "NbestStorage.h"
 #include "NistXmlCorpus.h"
+#include "ParallelFor.h"
+#include "PlainTextDocument.h"
 #include "SearchAlgorithm.h"
+#include "StepScheduler.h"
 
 void usage() {
 	std::cerr << "Usage: docent [-d moduleToDebug]"
+		" [-j threads]"
+		" [-b total-steps] [-c cpu-seconds] [-w wall-clock-seconds]"
 		" [-t moses-translations.xml]"
 		" config.xml [input.mmax-dir] input.xml"
 		<< std::endl;
@@ -47,18 +56,68 @@ void usage() {
 template<class Testset> void
 processTestset(
 	const DecoderConfiguration &config,
-	Testset &testset
+	Testset &testset,
+	uint nthreads
 );
 
+template<class Testset> void
+processTestsetWithBudget(
+	const DecoderConfiguration &config,
+	Testset &testset,
+	uint nthreads,
+	uint stepBudget,
+	Float cpuBudget
+);
+
+// number of steps a document is searched for at a time when a budget is
+// given for the whole test set
+const uint budgetSliceSteps = 1000;
+
 int main(int argc, char **argv)
 {
-	std::string configFile, mosesResultFilename;
+	std::string configFile, mosesResultFilename, maxJobTime;
+	uint nthreads = 1;
+	bool useBudget = false;
+	uint stepBudget = std::numeric_limits<uint>::max();
+	Float cpuBudget = std::numeric_limits<Float>::infinity();
 	std::vector<std::string> args;
 	for(int i = 1; i < argc; i++) {
 		if(!strcmp(argv[i], "-d")) {
 			if(i >= argc - 1)
 				usage();
 			Logger::setLogLevel(argv[++i], debug);
+		} else if(!strcmp(argv[i], "-j")) {
+			if(i >= argc - 1)
+				usage();
+			try {
+				nthreads = boost::lexical_cast<uint>(argv[++i]);
+			} catch(boost::bad_lexical_cast &) {
+				usage();
+			}
+			if(nthreads == 0)
+				usage();
+		} else if(!strcmp(argv[i], "-b")) {
+			if(i >= argc - 1)
+				usage();
+			try {
+				stepBudget = boost::lexical_cast<uint>(argv[++i]);
+			} catch(boost::bad_lexical_cast &) {
+				usage();
+			}
+			useBudget = true;
+		} else if(!strcmp(argv[i], "-c")) {
+			if(i >= argc - 1)
+				usage();
+			try {
+				cpuBudget = boost::lexical_cast<Float>(argv[++i]);
+			} catch(boost::bad_lexical_cast &) {
+				usage();
+			}
+			useBudget = true;
+		} else if(!strcmp(argv[i], "-w")) {
+			if(i >= argc - 1)
+				usage();
+			maxJobTime = argv[++i];
 		} else if(strcmp(argv[i], "-t") == 0) {
 			if(i >= argc - 1)
 				usage();
@@ -83,36 +142,135 @@ int main(int argc, char **argv)
 			mosesResultFilename
 		);
 	}
+	if(!maxJobTime.empty())
+		cf.modifyOrAddProperty("/docent/search", "max-job-time", maxJobTime);
 	DecoderConfiguration config(cf);
 
 	std::string inputMMAX, inputXML;
 	if(args.size() == 2) {
 		inputXML = args[1];
 		NistXmlCorpus testset(inputXML);
-		processTestset(config, testset);
+		if(useBudget)
+			processTestsetWithBudget(config, testset, nthreads, stepBudget, cpuBudget);
+		else
+			processTestset(config, testset, nthreads);
 	} else if(args.size() == 3) {
 		inputMMAX = args[1];
 		inputXML = args[2];
 		MMAXTestset testset(inputMMAX, inputXML);
-		processTestset(config, testset);
+		if(useBudget)
+			processTestsetWithBudget(config, testset, nthreads, stepBudget, cpuBudget);
+		else
+			processTestset(config, testset, nthreads);
 	}
 	return 0;
 }
 
+// Documents decoded in parallel report their scores from different threads
+// and out of order, so their score lines name the document. Serial runs keep
+// the plain format of the other docent binaries.
+static boost::mutex scoreOutputMutex;
+
+static void
+printScore(
+	const char *label,
+	uint docNum,
+	Float score,
+	bool withDocNum
+) {
+	boost::mutex::scoped_lock lock(scoreOutputMutex);
+	std::cerr << label << " score";
+	if(withDocNum)
+		std::cerr << " for document " << docNum;
+	std::cerr << ": " << score << std::endl;
+}
+
+template<class Document>
+static PlainTextDocument
+decodeDocument(
+	const DecoderConfiguration &config,
+	const Document &inputdoc,
+	uint docNum,
+	bool parallel
+) {
+	boost::shared_ptr<DocumentState> doc =
+		boost::make_shared<DocumentState>(config, inputdoc, docNum);
+	NbestStorage nbest(1);
+	printScore("Initial", docNum, doc->getScore(), parallel);
+	config.getSearchAlgorithm().search(doc, nbest);
+	printScore("Final", docNum, doc->getScore(), parallel);
+	return doc->asPlainTextDocument();
+}
+
+// The translations are only stored here because the input documents
+// share a DOM tree that must not be modified concurrently.
+template<class Document>
+static void
+decodeDocumentAt(
+	const DecoderConfiguration &config,
+	const std::vector<Document> &inputdocs,
+	std::vector<PlainTextDocument> &translations,
+	uint docNum
+) {
+	translations[docNum] = decodeDocument(config, inputdocs[docNum], docNum, true);
+}
+
 template<class Testset>
 void processTestset(
 	const DecoderConfiguration &config,
-	Testset &testset
+	Testset &testset,
+	uint nthreads
 ) {
+	config.getSearchAlgorithm().setJobSize(testset.size(), nthreads);
+	if(nthreads == 1) {
+		uint docNum = 0;
+		BOOST_FOREACH(typename Testset::value_type inputdoc, testset) {
+			inputdoc->setTranslation(decodeDocument(config, inputdoc, docNum, false));
+			docNum++;
+		}
+	} else {
+		std::vector<typename Testset::value_type> inputdocs;
+		inputdocs.reserve(testset.size());
+		BOOST_FOREACH(typename Testset::value_type inputdoc, testset)
+			inputdocs.push_back(inputdoc);
+
+		std::vector<PlainTextDocument> translations(inputdocs.size());
+		parallelFor(inputdocs.size(), nthreads, boost::bind(
+			&decodeDocumentAt<typename Testset::value_type>,
+			boost::cref(config), boost::cref(inputdocs), boost::ref(translations), _1));
+
+		for(uint i = 0; i < inputdocs.size(); i++)
+			inputdocs[i]->setTranslation(translations[i]);
+	}
+	testset.outputTranslation(std::cout);
+}
+
+template<class Testset>
+void processTestsetWithBudget(
+	const DecoderConfiguration &config,
+	Testset &testset,
+	uint nthreads,
+	uint stepBudget,
+	Float cpuBudget
+) {
+	config.getSearchAlgorithm().setJobSize(testset.size(), nthreads);
+	StepScheduler scheduler(config.getSearchAlgorithm(), budgetSliceSteps, nthreads);
 	uint docNum = 0;
 	BOOST_FOREACH(typename Testset::value_type inputdoc, testset) {
 		boost::shared_ptr<DocumentState> doc =
 			boost::make_shared<DocumentState>(config, inputdoc, docNum);
-		NbestStorage nbest(1);
-		std::cerr << "Initial score: " << doc->getScore() << std::endl;
-		config.getSearchAlgorithm().search(doc, nbest);
-		std::cerr << "Final score: " << doc->getScore() << std::endl;
-		inputdoc->setTranslation(doc->asPlainTextDocument());
+		printScore("Initial", docNum, doc->getScore(), true);
+		scheduler.addDocument(doc);
+		docNum++;
+	}
+
+	scheduler.run(stepBudget, cpuBudget);
+
+	docNum = 0;
+	BOOST_FOREACH(typename Testset::value_type inputdoc, testset) {
+		const DocumentState &best = scheduler.getBestDocumentState(docNum);
+		printScore("Final", docNum, best.getScore(), true);
+		inputdoc->setTranslation(best.asPlainTextDocument());
 		docNum++;
 	}
 	testset.outputTranslation(std::cout);
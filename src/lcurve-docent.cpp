@@ -21,6 +21,7 @@
  */
 
 #include <algorithm>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
 #include <iterator>
@@ -28,8 +29,13 @@
 #include <vector>
 
 #include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
 #include <boost/archive/text_oarchive.hpp>
+#include <boost/serialization/string.hpp>
 
 #include "Docent.h"
 #include "DecoderConfiguration.h"
@@ -38,6 +44,7 @@
 #include "NbestStorage.h"
 #include "NistXmlCorpus.h"
 #include "SearchAlgorithm.h"
+#include "TimeLimit.h"
 
 void usage() {
 	std::cerr << "Usage: lcurve-docent [-s xpath value] [-r xpath]"
@@ -45,6 +52,7 @@ void usage() {
 		" [-pf stateFileInitialisation] [-pl stateFileLast]"
 		" {-n input.xml | -m input.mmaxdir input.xml}"
 		" [-t moses-translations.xml]"
+		" [--checkpoint file [--checkpoint-interval seconds]]"
 		" config.xml outstem" << std::endl;
 	exit(1);
 }
@@ -103,10 +111,34 @@ void processTestset(
 	const std::string &outstem,
 	bool dumpStates,
 	const std::string &firstStateFilename,
-	const std::string &lastStateFilename
+	const std::string &lastStateFilename,
+	const std::string &checkpointFilename,
+	Float checkpointInterval
+);
+template<class Document>
+void annotateTranslation(
+	const DecoderConfiguration &config,
+	Document &inputdoc,
+	const DocumentState &doc
 );
 std::string formatWordAlignment(const PhraseSegmentation &snt);
 
+void writeCheckpoint(
+	const std::string &filename,
+	const SearchAlgorithm &algo,
+	const std::vector<SearchState *> &states,
+	const std::vector<NbestStorage> &nbest,
+	uint steps,
+	uint nextDoc
+);
+void readCheckpointHeader(
+	const std::string &filename,
+	boost::archive::binary_iarchive &ia,
+	uint ndocs,
+	uint &steps,
+	uint &nextDoc
+);
+
 void printState(
 	const std::string &filename,
 	const std::vector<std::vector<PhraseSegmentation> > &state
@@ -123,6 +155,8 @@ int main(int argc, char **argv)
 	bool dumpstates = false;
 	std::string mmax, nistxml;
 	std::string firstStateFilename, lastStateFilename, mosesResultFilename;
+	std::string checkpointFilename;
+	Float checkpointInterval = 600;
 
 	for(int i = 1; i < argc; i++) {
 		if(strcmp(argv[i], "-m") == 0) {
@@ -167,6 +201,19 @@ int main(int argc, char **argv)
 			lastStateFilename = argv[++i];
 		} else if(strcmp(argv[i], "--dumpstates") == 0) {
 			dumpstates = true;
+		} else if(strcmp(argv[i], "--checkpoint") == 0) {
+			if(i >= argc - 1)
+				usage();
+			checkpointFilename = argv[++i];
+		} else if(strcmp(argv[i], "--checkpoint-interval") == 0) {
+			if(i >= argc - 1)
+				usage();
+			try {
+				checkpointInterval = boost::lexical_cast<Float>(argv[++i]);
+			} catch(boost::bad_lexical_cast &) {
+				std::cerr << "Invalid checkpoint interval: " << argv[i] << std::endl;
+				usage();
+			}
 		} else {
 			args.push_back(argv[i]);
 		}
@@ -199,16 +246,20 @@ int main(int argc, char **argv)
 		MMAXTestset testset(mmax, nistxml);
 		if(translateSingleDocument) {
 			SingleDocumentTestset<MMAXTestset> single(testset);
-			processTestset(config, single, outstem, dumpstates, firstStateFilename, lastStateFilename);
+			processTestset(config, single, outstem, dumpstates, firstStateFilename, lastStateFilename,
+				checkpointFilename, checkpointInterval);
 		} else
-			processTestset(config, testset, outstem, dumpstates, firstStateFilename, lastStateFilename);
+			processTestset(config, testset, outstem, dumpstates, firstStateFilename, lastStateFilename,
+				checkpointFilename, checkpointInterval);
 	} else {
 		NistXmlCorpus testset(nistxml);
 		if(translateSingleDocument) {
 			SingleDocumentTestset<NistXmlCorpus> single(testset);
-			processTestset(config, single, outstem, dumpstates, firstStateFilename, lastStateFilename);
+			processTestset(config, single, outstem, dumpstates, firstStateFilename, lastStateFilename,
+				checkpointFilename, checkpointInterval);
 		} else
-			processTestset(config, testset, outstem, dumpstates, firstStateFilename, lastStateFilename);
+			processTestset(config, testset, outstem, dumpstates, firstStateFilename, lastStateFilename,
+				checkpointFilename, checkpointInterval);
 	}
 	return 0;
 }
@@ -221,7 +272,9 @@ void processTestset(
 	const std::string &outstem,
 	bool dumpStates,
 	const std::string &firstStateFilename,
-	const std::string &lastStateFilename
+	const std::string &lastStateFilename,
+	const std::string &checkpointFilename,
+	Float checkpointInterval
 ) {
 	try {
 		std::vector<typename Testset::value_type> inputdocs;
@@ -231,55 +284,78 @@ void processTestset(
 		BOOST_FOREACH(const typename Testset::value_type &inputdoc, testset)
 			inputdocs.push_back(inputdoc);
 
+		// When resuming from a checkpoint, the document states are restored
+		// from it instead of being initialised, and the learning curve continues
+		// with the first document not searched at the time the checkpoint was
+		// written.
+		uint firstSteps = 256;
+		uint firstDoc = 0;
+		std::ifstream checkpointStream;
+		boost::scoped_ptr<boost::archive::binary_iarchive> checkpoint;
+		if(!checkpointFilename.empty()) {
+			checkpointStream.open(checkpointFilename.c_str(), std::ios::binary);
+			if(checkpointStream.good()) {
+				checkpoint.reset(new boost::archive::binary_iarchive(checkpointStream));
+				readCheckpointHeader(checkpointFilename, *checkpoint, inputdocs.size(), firstSteps, firstDoc);
+			}
+		}
+		bool resumed = checkpoint.get() != NULL;
+
 		std::vector<SearchState *> states;
 		states.reserve(testset.size());
+		std::vector<NbestStorage> nbest(inputdocs.size(), NbestStorage(1));
 		const SearchAlgorithm &algo = config.getSearchAlgorithm();
 		uint docNum = 0;
 		BOOST_FOREACH(typename Testset::value_type inputdoc, inputdocs) {
-			boost::shared_ptr<DocumentState> doc =
-				boost::make_shared<DocumentState>(config, inputdoc, docNum);
-			states.push_back(algo.createState(doc));
-			std::cerr << "* " << docNum << "\t0\t" << doc->getScore() << std::endl;
-
-			PlainTextDocument ptout = doc->asPlainTextDocument();
-			for(uint sentNr = 0; sentNr < ptout.getNumberOfSentences(); sentNr++) {
-				std::ostringstream os;
-				Scores sntscores = doc->computeSentenceScores(sentNr);
-				os << std::inner_product(
-						sntscores.begin(), sntscores.end(),
-						config.getFeatureWeights().begin(),
-						Float(0)
-					)
-					<< " - " << sntscores
-					<< " - " << formatWordAlignment(doc->getPhraseSegmentation(sentNr));
-				inputdocs[docNum]->annotateSentence(sentNr, os.str());
+			if(resumed) {
+				boost::shared_ptr<DocumentState> doc(
+					new DocumentState(config, inputdoc, docNum, *checkpoint));
+				states.push_back(algo.loadCheckpoint(doc, *checkpoint));
+				nbest[docNum].loadCheckpoint(*checkpoint, *doc);
+				if(nbest[docNum].begin() != nbest[docNum].end())
+					annotateTranslation(config, inputdocs[docNum], *nbest[docNum].getBestDocumentState());
+			} else {
+				boost::shared_ptr<DocumentState> doc =
+					boost::make_shared<DocumentState>(config, inputdoc, docNum);
+				states.push_back(algo.createState(doc));
+				std::cerr << "* " << docNum << "\t0\t" << doc->getScore() << std::endl;
+				annotateTranslation(config, inputdocs[docNum], *doc);
 			}
-			std::ostringstream tos;
-			tos << doc->getScore() << " - " << doc->getScores();
-			inputdocs[docNum]->annotateDocument(tos.str());
-			inputdocs[docNum]->setTranslation(ptout);
-
 			docNum++;
 		}
-		std::ofstream of((outstem + ".000000000.xml").c_str());
-		of.exceptions(std::ofstream::failbit | std::ofstream::badbit);
-		testset.outputTranslation(of);
-		of.close();
 
-		// Print the state after initialization if asked for
-		if(!firstStateFilename.empty()) {
-			std::vector<std::vector<PhraseSegmentation> > state;
-			for(uint i = 0; i < states.size(); i++) {
-				state.push_back(states[i]->getLastDocumentState()->getPhraseSegmentations());
+		if(resumed) {
+			checkpoint.reset();
+			checkpointStream.close();
+			std::cerr << "Resuming from checkpoint at document " << firstDoc
+				<< ", " << firstSteps << " steps." << std::endl;
+		} else {
+			std::ofstream of((outstem + ".000000000.xml").c_str());
+			of.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+			testset.outputTranslation(of);
+			of.close();
+
+			// Print the state after initialization if asked for
+			if(!firstStateFilename.empty()) {
+				std::vector<std::vector<PhraseSegmentation> > state;
+				for(uint i = 0; i < states.size(); i++) {
+					const PhraseSegmentationVector &segs = states[i]->getLastDocumentState()->getPhraseSegmentations();
+					state.push_back(std::vector<PhraseSegmentation>(segs.begin(), segs.end()));
+				}
+				printState(firstStateFilename, state);
 			}
-			printState(firstStateFilename, state);
+
+			// Written right away so an algorithm without checkpoint support
+			// fails before any search time is spent.
+			if(!checkpointFilename.empty())
+				writeCheckpoint(checkpointFilename, algo, states, nbest, firstSteps, firstDoc);
 		}
 
-		uint steps_done = 0;
-		std::vector<NbestStorage> nbest(inputdocs.size(), NbestStorage(1));
+		TimeLimit::TimePoint lastCheckpoint = TimeLimit::now();
+		uint steps_done = firstSteps > 256 ? firstSteps / 2 : 0;
 
-		for(uint steps = 256; steps <= 134217728; steps *= 2) {
-			for(uint docNr = 0; docNr < inputdocs.size(); docNr++) {
+		for(uint steps = firstSteps; steps <= 134217728; steps *= 2) {
+			for(uint docNr = (steps == firstSteps ? firstDoc : 0); docNr < inputdocs.size(); docNr++) {
 				std::cerr << "Document " << docNr << ", approaching " << steps << " steps." << std::endl;
 				algo.search(
 					states[docNr],
@@ -291,26 +367,17 @@ void processTestset(
 				nbest[docNr].copyNbestList(out);
 				std::cerr << "Final score: " << out[0]->getScore() << std::endl;
 				std::cerr << "* " << docNr << '\t' << steps << '\t' << out[0]->getScore() << std::endl;
-				PlainTextDocument ptout = out[0]->asPlainTextDocument();
-				for(uint sentNr = 0; sentNr < ptout.getNumberOfSentences(); sentNr++) {
-					std::ostringstream os;
-					Scores sntscores = out[0]->computeSentenceScores(sentNr);
-					os << std::inner_product(
-							sntscores.begin(), sntscores.end(),
-							config.getFeatureWeights().begin(),
-							Float(0)
-						)
-						<< " - " << sntscores
-						<< " - " << formatWordAlignment(
-						out[0]->getPhraseSegmentation(sentNr));
-					inputdocs[docNr]->annotateSentence(sentNr, os.str());
-				}
-				std::ostringstream tos;
-				tos << out[0]->getScore() << " - " << out[0]->getScores();
-				inputdocs[docNr]->annotateDocument(tos.str());
-				inputdocs[docNr]->setTranslation(ptout);
+				annotateTranslation(config, inputdocs[docNr], *out[0]);
 				if(dumpStates)
 					out[0]->dumpFeatureFunctionStates();
+
+				if(!checkpointFilename.empty()) {
+					TimeLimit::TimePoint now = TimeLimit::now();
+					if(TimeLimit::secondsBetween(lastCheckpoint, now) >= checkpointInterval) {
+						writeCheckpoint(checkpointFilename, algo, states, nbest, steps, docNr + 1);
+						lastCheckpoint = now;
+					}
+				}
 			}
 			steps_done = steps;
 			std::ostringstream outname;
@@ -328,7 +395,8 @@ void processTestset(
 			std::vector<std::vector<PhraseSegmentation> > state;
 			for(uint i = 0; i < nbest.size(); i++) {
 				std::cerr << "getting state for sentence " << i << std::endl;
-				state.push_back(nbest[i].getBestDocumentState()->getPhraseSegmentations());
+				const PhraseSegmentationVector &segs = nbest[i].getBestDocumentState()->getPhraseSegmentations();
+				state.push_back(std::vector<PhraseSegmentation>(segs.begin(), segs.end()));
 			}
 			printState(lastStateFilename, state);
 		}
@@ -341,13 +409,38 @@ void processTestset(
 	}
 }
 
+template<class Document>
+void annotateTranslation(
+	const DecoderConfiguration &config,
+	Document &inputdoc,
+	const DocumentState &doc
+) {
+	PlainTextDocument ptout = doc.asPlainTextDocument();
+	for(uint sentNr = 0; sentNr < ptout.getNumberOfSentences(); sentNr++) {
+		std::ostringstream os;
+		Scores sntscores = doc.computeSentenceScores(sentNr);
+		os << std::inner_product(
+				sntscores.begin(), sntscores.end(),
+				config.getFeatureWeights().begin(),
+				Float(0)
+			)
+			<< " - " << sntscores
+			<< " - " << formatWordAlignment(doc.getPhraseSegmentation(sentNr));
+		inputdoc->annotateSentence(sentNr, os.str());
+	}
+	std::ostringstream tos;
+	tos << doc.getScore() << " - " << doc.getScores();
+	inputdoc->annotateDocument(tos.str());
+	inputdoc->setTranslation(ptout);
+}
+
 std::string formatWordAlignment(
 	const PhraseSegmentation &snt
 ) {
 	std::ostringstream out;
 	uint tgtoffset = 0;
 	BOOST_FOREACH(const AnchoredPhrasePair &app, snt) {
-		uint srcoffset = app.first.find_first();
+		uint srcoffset = app.first.start;
 		const WordAlignment &wa = app.second.get().getWordAlignment();
 		for(uint t = 0;
 			t < app.second.get().getTargetPhrase().get().size();
@@ -376,3 +469,70 @@ void printState(
 	boost::archive::text_oarchive oa(ofs);
 	oa << state;
 }
+
+static const std::string checkpointMagic = "docent-lcurve-checkpoint";
+static const uint checkpointVersion = 2;
+
+// The checkpoint is written to a temporary file first and then renamed, so
+// an interruption while writing leaves the previous checkpoint intact.
+void writeCheckpoint(
+	const std::string &filename,
+	const SearchAlgorithm &algo,
+	const std::vector<SearchState *> &states,
+	const std::vector<NbestStorage> &nbest,
+	uint steps,
+	uint nextDoc
+) {
+	std::string tmpname = filename + ".tmp";
+	std::ofstream ofs(tmpname.c_str(), std::ios::binary);
+	ofs.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+	{
+		boost::archive::binary_oarchive oa(ofs);
+		uint ndocs = states.size();
+		oa << checkpointMagic;
+		oa << checkpointVersion;
+		oa << steps;
+		oa << nextDoc;
+		oa << ndocs;
+		for(uint i = 0; i < states.size(); i++) {
+			states[i]->getLastDocumentState()->saveCheckpoint(oa);
+			algo.saveCheckpoint(states[i], oa);
+			nbest[i].saveCheckpoint(oa);
+		}
+	}
+	ofs.close();
+	if(std::rename(tmpname.c_str(), filename.c_str()) != 0) {
+		std::cerr << "Can't rename " << tmpname << " to " << filename << std::endl;
+		exit(1);
+	}
+	std::cerr << "Checkpoint written at document " << nextDoc
+		<< ", " << steps << " steps." << std::endl;
+}
+
+// Reads the header of an open checkpoint for a test set of ndocs documents.
+// The document and search states follow it, one document after the other.
+void readCheckpointHeader(
+	const std::string &filename,
+	boost::archive::binary_iarchive &ia,
+	uint ndocs,
+	uint &steps,
+	uint &nextDoc
+) {
+	std::string magic;
+	uint version;
+	uint checkpointDocs;
+	ia >> magic;
+	ia >> version;
+	if(magic != checkpointMagic || version != checkpointVersion) {
+		std::cerr << filename << " is not a checkpoint file of this version of lcurve-docent." << std::endl;
+		exit(1);
+	}
+	ia >> steps;
+	ia >> nextDoc;
+	ia >> checkpointDocs;
+	if(checkpointDocs != ndocs) {
+		std::cerr << "Checkpoint " << filename << " is for " << checkpointDocs
+			<< " documents, but the input has " << ndocs << "." << std::endl;
+		exit(1);
+	}
+}
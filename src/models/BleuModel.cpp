@@ -25,8 +25,8 @@ struct BleuModelState : public FeatureFunction::State {
 };
 
 struct BleuModelModifications : public FeatureFunction::StateModifications {
-	// each entry in the modifications vector contains a sentence number and a vector of tokens
-	std::vector<std::pair<uint,std::vector<std::string> > > state_mods;
+	// each entry in the modifications vector contains a sentence number and a vector of token IDs
+	std::vector<std::pair<uint,std::vector<WordId> > > state_mods;
 };
 
 // constructor
@@ -66,7 +66,7 @@ BleuModel::BleuModel(
 				word_it != plain_doc.sentence_end(sentno);
 				++word_it
 			) {
-				tokens.push_back(*word_it);
+				tokens.push_back(Vocabulary::getId(*word_it));
 				sentence_length++;
 				doc_length++;
 				//LOG(logger_, debug, "Word: " << *word_it);
@@ -131,7 +131,7 @@ FeatureFunction::State *BleuModel::initDocument(
 
 	LOG(logger_, debug, "Initialising Document " << doc_no);
 
-	const std::vector<PhraseSegmentation> &segs = doc.getPhraseSegmentations();
+	const PhraseSegmentationVector &segs = doc.getPhraseSegmentations();
 	uint no_sents = segs.size();
 
 	// initialise state variables to the correct size
@@ -153,8 +153,8 @@ FeatureFunction::State *BleuModel::initDocument(
 		while(ng_it != to_it) {
 			candidate_tokens.insert(
 				candidate_tokens.end(),
-				ng_it->second.get().getTargetPhrase().get().begin(),
-				ng_it->second.get().getTargetPhrase().get().end()
+				ng_it->second.get().getTargetWordIds().begin(),
+				ng_it->second.get().getTargetWordIds().end()
 			);
 			++ng_it;
 		}
@@ -214,8 +214,8 @@ FeatureFunction::StateModifications
 		while(ng_it!=mod_it->from_it) {
 			modified_tokens.insert(
 				modified_tokens.end(),
-				ng_it->second.get().getTargetPhrase().get().begin(),
-				ng_it->second.get().getTargetPhrase().get().end()
+				ng_it->second.get().getTargetWordIds().begin(),
+				ng_it->second.get().getTargetWordIds().end()
 			);
 			++ng_it;
 		}
@@ -226,8 +226,8 @@ FeatureFunction::StateModifications
 		while(prop_it != mod_it->proposal.end()) {
 			modified_tokens.insert(
 				modified_tokens.end(),
-				prop_it->second.get().getTargetPhrase().get().begin(),
-				prop_it->second.get().getTargetPhrase().get().end()
+				prop_it->second.get().getTargetWordIds().begin(),
+				prop_it->second.get().getTargetWordIds().end()
 			);
 			++prop_it;
 		}
@@ -244,8 +244,8 @@ FeatureFunction::StateModifications
 			while(ng_it!=mod_it->from_it) {
 				modified_tokens.insert(
 					modified_tokens.end(),
-					ng_it->second.get().getTargetPhrase().get().begin(),
-					ng_it->second.get().getTargetPhrase().get().end()
+					ng_it->second.get().getTargetWordIds().begin(),
+					ng_it->second.get().getTargetWordIds().end()
 				);
 				++ng_it;
 			}
@@ -256,8 +256,8 @@ FeatureFunction::StateModifications
 			while(prop_it != mod_it->proposal.end()) {
 				modified_tokens.insert(
 					modified_tokens.end(),
-					prop_it->second.get().getTargetPhrase().get().begin(),
-					prop_it->second.get().getTargetPhrase().get().end()
+					prop_it->second.get().getTargetWordIds().begin(),
+					prop_it->second.get().getTargetWordIds().end()
 				);
 				++prop_it;
 			}
@@ -272,8 +272,8 @@ FeatureFunction::StateModifications
 		while(ng_it != to_it) {
 			modified_tokens.insert(
 				modified_tokens.end(),
-				ng_it->second.get().getTargetPhrase().get().begin(),
-				ng_it->second.get().getTargetPhrase().get().end()
+				ng_it->second.get().getTargetWordIds().begin(),
+				ng_it->second.get().getTargetWordIds().end()
 			);
 			++ng_it;
 		}
@@ -445,6 +445,6 @@ void BleuModel::printTokens(
 	BleuModel::Tokens_ tokens
 ) const {
 	for(Tokens_::iterator it = tokens.begin(); it!= tokens.end(); ++it) {
-		LOG(logger_, debug, *it);
+		LOG(logger_, debug, Vocabulary::getWord(*it));
 	}
 }
@@ -5,10 +5,11 @@
 
 #include "Docent.h"
 #include "FeatureFunction.h"
+#include "Vocabulary.h"
 
 class BleuModel : public FeatureFunction {
 private:
-	typedef std::vector<std::string> Tokens_;
+	typedef std::vector<WordId> Tokens_;
 	typedef std::vector<Tokens_> Sents_;
 	typedef boost::unordered_map<Tokens_,uint> TokenHash_;
 	Logger logger_;
@@ -25,6 +25,7 @@
 #include "FeatureFunction.h"
 #include "SearchStep.h"
 #include "models/BracketingModel.h"
+#include "models/CountDelta.h"
 
 #include <boost/foreach.hpp>
 #include <boost/regex.hpp>
@@ -35,8 +36,7 @@
 #include <sstream>
 
 struct BracketingModelState
-:	public FeatureFunction::State,
-	public FeatureFunction::StateModifications
+:	public FeatureFunction::State
 {
 	BracketingModelState(uint nsents) : logger_("BracketingModel") {}
 
@@ -46,26 +46,18 @@ struct BracketingModelState
 	TagCounts_ opentagcount;
 	TagCounts_ closetagcount;
 
-	TagList_ taglist;
-
 	mutable Logger logger_;
 
+	// Score of the tag counts after applying the changes in opendelta.
 	Float score(
+		const TagList_ &taglist,
+		const CountDelta<std::string> &opendelta
 	) const {
 		uint diff = 0;
 		for(TagList_::const_iterator it = taglist.begin(); it != taglist.end(); ++it){
-			uint open = 0;
-			uint closed = 0;
-
-			TagCounts_::const_iterator tagIt1 = opentagcount.find(it->first);
-			if (tagIt1 != opentagcount.end()){
-				open = tagIt1->second;
-			}
-			TagCounts_::const_iterator tagIt2 = opentagcount.find(it->second);
-			if (tagIt2 != opentagcount.end()){
-				closed = tagIt2->second;
-			}
-			diff += abs(open - closed);
+			uint open = opendelta.getCount(opentagcount, it->first);
+			uint closed = opendelta.getCount(opentagcount, it->second);
+			diff += std::abs(int(open) - int(closed));
 		}
 		return -Float(diff);
 	}
@@ -75,6 +67,13 @@ struct BracketingModelState
 	}
 };
 
+struct BracketingModelModifications
+:	public FeatureFunction::StateModifications
+{
+	CountDelta<std::string> opentagcount;
+	CountDelta<std::string> closetagcount;
+};
+
 
 BracketingModel::BracketingModel(
 	const Parameters &params
@@ -101,18 +100,13 @@ FeatureFunction::State
 	const DocumentState &doc,
 	Scores::iterator sbegin
 ) const {
-	const std::vector<PhraseSegmentation> &segs = doc.getPhraseSegmentations();
+	const PhraseSegmentationVector &segs = doc.getPhraseSegmentations();
 
 	BracketingModelState *s = new BracketingModelState(segs.size());
 
 	static const boost::regex opentagRE("\\[(.*)\\]");
 	static const boost::regex closetagRE("\\[\\/(.*)\\]");
 
-	for(TagList_::const_iterator it = opentaglist.begin(); it != opentaglist.end(); ++it){
-		// s->taglist.insert(it->first,it->second);
-		s->taglist[it->first] = it->second;
-	}
-
 	for(uint i = 0; i < segs.size(); i++) {
 		BOOST_FOREACH(const AnchoredPhrasePair &app, segs[i]) {
 			BOOST_FOREACH(const std::string &w, app.second.get().getTargetPhrase().get()) {
@@ -135,7 +129,7 @@ FeatureFunction::State
 		}
 	}
 
-	*sbegin = s->score();
+	*sbegin = s->score(opentaglist, CountDelta<std::string>());
 	return s;
 }
 
@@ -160,7 +154,7 @@ FeatureFunction::StateModifications
 	static const boost::regex closetagRE("\\[\\/(.*)\\]");
 
 	const BracketingModelState *prevstate = dynamic_cast<const BracketingModelState *>(state);
-	BracketingModelState *s = prevstate->clone();
+	BracketingModelModifications *s = new BracketingModelModifications();
 
 	const std::vector<SearchStep::Modification> &mods = step.getModifications();
 	for(std::vector<SearchStep::Modification>::const_iterator
@@ -182,22 +176,22 @@ FeatureFunction::StateModifications
 		) {
 			BOOST_FOREACH(const std::string &w, pit->second.get().getTargetPhrase().get()) {
 				if (opentaglist.find(w) != opentaglist.end()){
-					s->opentagcount[w]--;
-					LOG(logger_, debug, "removed opening tag " << w << " (" << s->opentagcount[w] << ")");
+					s->opentagcount.remove(w);
+					LOG(logger_, debug, "removed opening tag " << w << " (" << s->opentagcount.getCount(prevstate->opentagcount, w) << ")");
 				}
 				// TODO: is it OK that tags can be counted as both (opening and closing tag?)
 				if (closetaglist.find(w) != closetaglist.end()){
-					s->closetagcount[w]--;
-					LOG(logger_, debug, "removed closing tag " << w << " (" << s->closetagcount[w] << ")");
+					s->closetagcount.remove(w);
+					LOG(logger_, debug, "removed closing tag " << w << " (" << s->closetagcount.getCount(prevstate->closetagcount, w) << ")");
 				}
 				boost::match_results<std::string::const_iterator> result1;
 				boost::match_results<std::string::const_iterator> result2;
 				if (boost::regex_match(w, result2, closetagRE)) {
-					s->closetagcount[result2[1]]--;
-					LOG(logger_, debug, "removed closing tag " << w << " (" << s->closetagcount[w] << ")");
+					s->closetagcount.remove(result2[1]);
+					LOG(logger_, debug, "removed closing tag " << w << " (" << s->closetagcount.getCount(prevstate->closetagcount, w) << ")");
 				} else if (boost::regex_match(w, result1, opentagRE)) {
-					s->opentagcount[result1[1]]--;
-					LOG(logger_, debug, "removed opening tag " << w << " (" << s->opentagcount[w] << ")");
+					s->opentagcount.remove(result1[1]);
+					LOG(logger_, debug, "removed opening tag " << w << " (" << s->opentagcount.getCount(prevstate->opentagcount, w) << ")");
 				}
 			}
 		}
@@ -205,28 +199,28 @@ FeatureFunction::StateModifications
 		BOOST_FOREACH(const AnchoredPhrasePair &app, it->proposal) {
 			BOOST_FOREACH(const std::string &w, app.second.get().getTargetPhrase().get()) {
 				if(opentaglist.find(w) != opentaglist.end()){
-					s->opentagcount[w]++;
-					LOG(logger_, debug, "added opening tag " << w << " (" << s->opentagcount[w] << ")");
+					s->opentagcount.add(w);
+					LOG(logger_, debug, "added opening tag " << w << " (" << s->opentagcount.getCount(prevstate->opentagcount, w) << ")");
 				}
 				// TODO: is it OK that tags can be counted as both (opening and closing tag?)
 				if(closetaglist.find(w) != closetaglist.end()){
-					s->closetagcount[w]++;
-					LOG(logger_, debug, "added closing tag " << w << " (" << s->closetagcount[w] << ")");
+					s->closetagcount.add(w);
+					LOG(logger_, debug, "added closing tag " << w << " (" << s->closetagcount.getCount(prevstate->closetagcount, w) << ")");
 				}
 				boost::match_results<std::string::const_iterator> result1;
 				boost::match_results<std::string::const_iterator> result2;
 				if(boost::regex_match(w, result2, closetagRE)) {
-					s->closetagcount[result2[1]]++;
-					LOG(logger_, debug, "added closing tag " << w << " (" << s->closetagcount[w] << ")");
+					s->closetagcount.add(result2[1]);
+					LOG(logger_, debug, "added closing tag " << w << " (" << s->closetagcount.getCount(prevstate->closetagcount, w) << ")");
 				} else if (boost::regex_match(w, result1, opentagRE)) {
-					s->opentagcount[result1[1]]++;
-					LOG(logger_, debug, "added opening tag " << w << " (" << s->opentagcount[w] << ")");
+					s->opentagcount.add(result1[1]);
+					LOG(logger_, debug, "added opening tag " << w << " (" << s->opentagcount.getCount(prevstate->opentagcount, w) << ")");
 				}
 			}
 		}
 	}
 
-	*sbegin = s->score();
+	*sbegin = prevstate->score(opentaglist, s->opentagcount);
 	return s;
 }
 
@@ -248,11 +242,10 @@ FeatureFunction::State
 	FeatureFunction::StateModifications *modif
 ) const {
 	BracketingModelState *os = dynamic_cast<BracketingModelState *>(oldState);
-	BracketingModelState *ms = dynamic_cast<BracketingModelState *>(modif);
+	BracketingModelModifications *ms = dynamic_cast<BracketingModelModifications *>(modif);
 
-	os->opentagcount.swap(ms->opentagcount);
-	os->closetagcount.swap(ms->closetagcount);
-	os->taglist.swap(ms->taglist);
+	ms->opentagcount.apply(os->opentagcount);
+	ms->closetagcount.apply(os->closetagcount);
 
 	return oldState;
 }
@@ -0,0 +1,197 @@
+/*
+ *  ConsistencyQCounts.h
+ *
+ *  Copyright 2012 by Christian Hardmeier. All rights reserved.
+ *
+ *  This file is part of Docent, a document-level decoder for phrase-based
+ *  statistical machine translation.
+ *
+ *  Docent is free software: you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation, either version 3 of the License, or (at your option) any later
+ *  version.
+ *
+ *  Docent is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  Docent. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef docent_ConsistencyQCounts_h
+#define docent_ConsistencyQCounts_h
+
+#include "Docent.h"
+#include "models/CountDelta.h"
+
+#include <cmath>
+#include <map>
+#include <set>
+#include <utility>
+
+/**
+ * Counts of aligned source/target pairs for the consistency q-value models.
+ * The score is the frequency-weighted average q-value of the pairs,
+ *
+ *   q(s,t) = f(s,t) / (spread(s) + spread(t)),
+ *
+ * where the spread of an item is the number of different items it is aligned
+ * to in the document. The sum of f(s,t) q(s,t) is kept up to date, so a
+ * search step can be scored by recomputing only the terms of the pairs whose
+ * frequency or spread it changes, without copying the counts. To keep
+ * rounding errors from adding up, the sum is recomputed from scratch every
+ * resyncInterval applied steps.
+ */
+template<class Key>
+class ConsistencyQCounts {
+public:
+	typedef std::pair<Key,Key> KeyPair;
+	typedef CountDelta<KeyPair> Delta;
+
+private:
+	typedef std::map<Key,uint> Row_;
+	typedef std::map<Key,Row_> Table_;
+
+	Table_ s2t_;
+	Table_ t2s_;
+	double qsum_;
+	uint total_;
+	uint appliedSinceResync_;
+
+	static uint getSpread(const Table_ &table, const Key &k) {
+		typename Table_::const_iterator it = table.find(k);
+		return it == table.end() ? 0 : it->second.size();
+	}
+
+	uint getFreq(const KeyPair &p) const {
+		typename Table_::const_iterator it1 = s2t_.find(p.first);
+		if(it1 == s2t_.end())
+			return 0;
+		typename Row_::const_iterator it2 = it1->second.find(p.second);
+		return it2 == it1->second.end() ? 0 : it2->second;
+	}
+
+	static double term(uint freq, uint sspread, uint tspread) {
+		if(freq == 0)
+			return 0;
+		return double(freq) * freq / (sspread + tspread);
+	}
+
+	static void addToTable(Table_ &table, const Key &k1, const Key &k2, int n) {
+		Row_ &row = table[k1];
+		uint &c = row[k2];
+		c += n;
+		if(c == 0) {
+			row.erase(k2);
+			if(row.empty())
+				table.erase(k1);
+		}
+	}
+
+public:
+	static const uint resyncInterval = 1024;
+
+	ConsistencyQCounts() : qsum_(0), total_(0), appliedSinceResync_(0) {}
+
+	static Float score(double qsum, uint total) {
+		return log(qsum / total);
+	}
+
+	Float score() const {
+		return score(qsum_, total_);
+	}
+
+	// Adds a pair without updating the score. Call computeScore() when done.
+	void add(const Key &s, const Key &t) {
+		addToTable(s2t_, s, t, 1);
+		addToTable(t2s_, t, s, 1);
+		total_++;
+	}
+
+	void computeScore() {
+		appliedSinceResync_ = 0;
+		qsum_ = 0;
+		for(typename Table_::const_iterator it1 = s2t_.begin(); it1 != s2t_.end(); ++it1)
+			for(typename Row_::const_iterator it2 = it1->second.begin(); it2 != it1->second.end(); ++it2)
+				qsum_ += term(it2->second, it1->second.size(), getSpread(t2s_, it2->first));
+	}
+
+	// Computes the weighted q-value sum and the total frequency of the counts
+	// after applying delta.
+	void computeUpdate(const Delta &delta, double &qsum, uint &total) const {
+		const typename Delta::ChangeList &changes = delta.getChanges();
+
+		CountDelta<Key> sspread;
+		CountDelta<Key> tspread;
+		std::set<KeyPair> affected;
+		int dtotal = 0;
+		for(typename Delta::ChangeList::const_iterator it = changes.begin(); it != changes.end(); ++it) {
+			if(it->second == 0)
+				continue;
+			dtotal += it->second;
+			affected.insert(it->first);
+			uint oldFreq = getFreq(it->first);
+			uint newFreq = oldFreq + it->second;
+			if(oldFreq == 0 && newFreq != 0) {
+				sspread.add(it->first.first);
+				tspread.add(it->first.second);
+			} else if(oldFreq != 0 && newFreq == 0) {
+				sspread.remove(it->first.first);
+				tspread.remove(it->first.second);
+			}
+		}
+
+		// A change of spread affects all pairs containing the item.
+		typedef typename CountDelta<Key>::ChangeList SpreadChanges_;
+		for(typename SpreadChanges_::const_iterator it = sspread.getChanges().begin(); it != sspread.getChanges().end(); ++it) {
+			typename Table_::const_iterator row = s2t_.find(it->first);
+			if(it->second == 0 || row == s2t_.end())
+				continue;
+			for(typename Row_::const_iterator it2 = row->second.begin(); it2 != row->second.end(); ++it2)
+				affected.insert(KeyPair(it->first, it2->first));
+		}
+		for(typename SpreadChanges_::const_iterator it = tspread.getChanges().begin(); it != tspread.getChanges().end(); ++it) {
+			typename Table_::const_iterator row = t2s_.find(it->first);
+			if(it->second == 0 || row == t2s_.end())
+				continue;
+			for(typename Row_::const_iterator it2 = row->second.begin(); it2 != row->second.end(); ++it2)
+				affected.insert(KeyPair(it2->first, it->first));
+		}
+
+		qsum = qsum_;
+		for(typename std::set<KeyPair>::const_iterator it = affected.begin(); it != affected.end(); ++it) {
+			uint oldFreq = getFreq(*it);
+			uint oldSSpread = getSpread(s2t_, it->first);
+			uint oldTSpread = getSpread(t2s_, it->second);
+			qsum += term(oldFreq + delta.get(*it),
+					oldSSpread + sspread.get(it->first),
+					oldTSpread + tspread.get(it->second))
+				- term(oldFreq, oldSSpread, oldTSpread);
+		}
+		total = total_ + dtotal;
+	}
+
+	// Applies delta, whose updated sums must have been computed with
+	// computeUpdate.
+	void apply(const Delta &delta, double qsum, uint total) {
+		const typename Delta::ChangeList &changes = delta.getChanges();
+		for(typename Delta::ChangeList::const_iterator it = changes.begin(); it != changes.end(); ++it) {
+			if(it->second == 0)
+				continue;
+			addToTable(s2t_, it->first.first, it->first.second, it->second);
+			addToTable(t2s_, it->first.second, it->first.first, it->second);
+		}
+		total_ = total;
+		if(++appliedSinceResync_ >= resyncInterval)
+			computeScore();
+		else
+			qsum_ = qsum;
+	}
+};
+
+template<class Key>
+const uint ConsistencyQCounts<Key>::resyncInterval;
+
+#endif
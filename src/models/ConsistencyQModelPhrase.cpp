@@ -23,137 +23,46 @@
 #include "Docent.h"
 #include "DocumentState.h"
 #include "SearchStep.h"
+#include "models/ConsistencyQCounts.h"
 #include "models/ConsistencyQModelPhrase.h"
 
 #include <boost/foreach.hpp>
 
-#include <map>
-
 using namespace std;
 
-struct QCount
-{
-	QCount() : freq(0), sSpread(0), tSpread(0) {}
-
-	QCount& operator++ () {
-		freq++;
-		return *this;
-	}
-
-	QCount operator++ (int) {
-		QCount res (*this);
-		++(*this);
-		return res;
-	}
-
-	QCount& operator-- () {
-		freq--;
-		return *this;
-	}
-
-	QCount operator-- (int) {
-		QCount res (*this);
-		--(*this);
-		return res;
-	}
-
-	bool empty() {
-		return freq <= 0;
-	}
-
-	uint freq;
-	uint sSpread;
-	uint tSpread;
-};
-
-
-struct PhraseMap
+struct ConsistencyQModelPhraseState
+:	public FeatureFunction::State
 {
-	typedef std::map<Phrase,QCount> PhraseScore_;
-	typedef std::map<Phrase,PhraseScore_> PhrasePairMap_;
+	ConsistencyQModelPhraseState(uint nsents) {} // :  sentencePairs(nsents) {}
 
-	PhrasePairMap_ pMap;
+	ConsistencyQCounts<Phrase> counts;
 
-	void swap(PhraseMap& other) {
-		this->pMap.swap(other.pMap);
+	Float score() const {
+		return counts.score();
 	}
 
-
-	void addPhrasePair(const Phrase& p1, const Phrase& p2) {
-		pMap[p1][p2]++;
-	}
-
-	void removePhrasePair(const Phrase& p1, const Phrase& p2) {
-		pMap[p1][p2]--;
-		if (pMap[p1][p2].empty()) {
-			pMap[p1].erase(p2);
-			if (pMap[p1].size() == 0) {
-				pMap.erase(p1);
-			}
-		}
-	}
-
-	uint getPhrasePairFreq(const Phrase& p1, const Phrase& p2) const {
-		return pMap.find(p1)->second.find(p2)->second.freq;
-	}
-
-	float getPhraseSpread(const Phrase& p) const {
-		return pMap.find(p)->second.size();
+	void addPhrasePair(const AnchoredPhrasePair& app) {
+		counts.add(app.second.get().getSourcePhrase(), app.second.get().getTargetPhrase());
 	}
 
-	float scoreAll(const PhraseMap& pm) const {
-		float score = 0;
-		float numPhrases = 0;
-		for(PhrasePairMap_::const_iterator it1=pMap.begin() ; it1 != pMap.end(); it1++ ) {
-			//q-VALUE = TPF / (TpS + SpT)
-			PhraseScore_ ps = it1->second;
-			for(PhraseScore_::const_iterator it2=ps.begin() ; it2 != ps.end(); it2++ ) {
-				//weight the score by the number of occurences of the phrase pair
-				float newScore = it2->second.freq * it2->second.freq/(it1->second.size() + pm.getPhraseSpread(it2->first));
-				score += newScore;
-				numPhrases += it2->second.freq;
-			}
-		}
-		return score/numPhrases;
+	virtual ConsistencyQModelPhraseState *clone() const {
+		return new ConsistencyQModelPhraseState(*this);
 	}
 };
 
-
-struct ConsistencyQModelPhraseState
-:	public FeatureFunction::State,
-	public FeatureFunction::StateModifications
+struct ConsistencyQModelPhraseModifications
+:	public FeatureFunction::StateModifications
 {
-	ConsistencyQModelPhraseState(uint nsents) : oldScore(0) {} // :  sentencePairs(nsents) {}
-
-	PhraseMap s2t;
-	PhraseMap t2s;
+	ConsistencyQModelPhraseModifications() : qsum(0), total(0) {}
 
-	float oldScore;
+	ConsistencyQCounts<Phrase>::Delta pairs;
+	double qsum;
+	uint total;
 
-	//Not currently used - would probably be needed for doing more efficient scoring. But needs revising data structures...)
-	//  std::vector<PhrasePair> sentencePairs;
-
-	Float score() {
-		oldScore = log(s2t.scoreAll(t2s));
-		return oldScore;
-	}
-
-	void addPhrasePair(const AnchoredPhrasePair& app) {
-		Phrase t = app.second.get().getTargetPhrase();
-		Phrase s = app.second.get().getSourcePhrase();
-		s2t.addPhrasePair(s,t);
-		t2s.addPhrasePair(t,s);
-	}
-
-	void removePhrasePair(const AnchoredPhrasePair& app) {
-		Phrase t = app.second.get().getTargetPhrase();
-		Phrase s = app.second.get().getSourcePhrase();
-		s2t.removePhrasePair(s,t);
-		t2s.removePhrasePair(t,s);
-	}
-
-	virtual ConsistencyQModelPhraseState *clone() const {
-		return new ConsistencyQModelPhraseState(*this);
+	void addPhrasePair(const AnchoredPhrasePair& app, int n) {
+		pairs.add(ConsistencyQCounts<Phrase>::KeyPair(
+			app.second.get().getSourcePhrase(),
+			app.second.get().getTargetPhrase()), n);
 	}
 };
 
@@ -163,7 +72,7 @@ FeatureFunction::State
 	const DocumentState &doc,
 	Scores::iterator sbegin
 ) const {
-	const std::vector<PhraseSegmentation> &segs = doc.getPhraseSegmentations();
+	const PhraseSegmentationVector &segs = doc.getPhraseSegmentations();
 
 	ConsistencyQModelPhraseState *s = new ConsistencyQModelPhraseState(segs.size());
 	for(uint i = 0; i < segs.size(); i++) {
@@ -173,6 +82,7 @@ FeatureFunction::State
 	}
 
 
+	s->counts.computeScore();
 	*sbegin = s->score();
 	return s;
 }
@@ -195,7 +105,7 @@ FeatureFunction::StateModifications
 ) const {
 	const ConsistencyQModelPhraseState *prevstate =
 		dynamic_cast<const ConsistencyQModelPhraseState *>(state);
-	ConsistencyQModelPhraseState *s = prevstate->clone();
+	ConsistencyQModelPhraseModifications *s = new ConsistencyQModelPhraseModifications();
 
 	const std::vector<SearchStep::Modification> &mods = step.getModifications();
 	for(std::vector<SearchStep::Modification>::const_iterator
@@ -209,16 +119,17 @@ FeatureFunction::StateModifications
 			PhraseSegmentation::const_iterator to_it = it->to_it;
 
 			for(PhraseSegmentation::const_iterator pit=from_it; pit != to_it; pit++) {
-				s->removePhrasePair(*pit);
+				s->addPhrasePair(*pit, -1);
 			}
 
 			BOOST_FOREACH(const AnchoredPhrasePair &app, it->proposal) {
-				s->addPhrasePair(app);
+				s->addPhrasePair(app, 1);
 			}
 		}
 	}
 
-	*sbegin = s->score();
+	prevstate->counts.computeUpdate(s->pairs, s->qsum, s->total);
+	*sbegin = ConsistencyQCounts<Phrase>::score(s->qsum, s->total);
 	return s;
 }
 
@@ -240,9 +151,8 @@ FeatureFunction::State
 	FeatureFunction::StateModifications *modif
 ) const {
 	ConsistencyQModelPhraseState *os = dynamic_cast<ConsistencyQModelPhraseState *>(oldState);
-	ConsistencyQModelPhraseState *ms = dynamic_cast<ConsistencyQModelPhraseState *>(modif);
+	ConsistencyQModelPhraseModifications *ms = dynamic_cast<ConsistencyQModelPhraseModifications *>(modif);
 
-	os->s2t.swap(ms->s2t);
-	os->t2s.swap(ms->t2s);
+	os->counts.apply(ms->pairs, ms->qsum, ms->total);
 	return oldState;
 }
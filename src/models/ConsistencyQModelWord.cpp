@@ -23,151 +23,73 @@
 #include "Docent.h"
 #include "DocumentState.h"
 #include "SearchStep.h"
+#include "models/ConsistencyQCounts.h"
 #include "models/ConsistencyQModelWord.h"
 
 #include <boost/foreach.hpp>
 
 #include <iostream>
-#include <map>
 
 using namespace std;
 
-struct QCount
-{
-	QCount() : freq(0) {}
-
-	QCount& operator++ () {
-		freq++;
-		return *this;
-	}
-
-	QCount operator++ (int) {
-		QCount res (*this);
-		++(*this);
-		return res;
-	}
-
-	QCount& operator-- () {
-		freq--;
-		return *this;
-	}
-
-	QCount operator-- (int) {
-		QCount res (*this);
-		--(*this);
-		return res;
-	}
-
-	bool empty() {
-		return freq <= 0;
-	}
-
-	uint freq;
-};
-
-
-struct AlignMap
+struct ConsistencyQModelWordState
+:	public FeatureFunction::State
 {
-	typedef std::map<std::string,QCount> AlignScore_;
-	typedef std::map<std::string,AlignScore_> AlignPairMap_;
+	ConsistencyQModelWordState(uint nsents) {}
 
-	AlignPairMap_ pMap;
+	ConsistencyQCounts<WordId> counts;
 
-	void swap(AlignMap& other) {
-		this->pMap.swap(other.pMap);
+	Float score() const {
+		return counts.score();
 	}
 
-	void addAlignPair(const std::string& p1, const std::string& p2) {
-		pMap[p1][p2]++;
-	}
-
-	void removeAlignPair(const std::string& p1, const std::string& p2) {
-		pMap[p1][p2]--;
-		if (pMap[p1][p2].empty()) {
-			pMap[p1].erase(p2);
-			if (pMap[p1].size() == 0) {
-				pMap.erase(p1);
-			}
+	// The source side of a target word is the concatenation of the source
+	// words aligned to it. Most target words are aligned to exactly one
+	// source word, whose ID can be used without building the string.
+	static WordId getAlignedSource(const PhrasePairData &pp, uint i) {
+		const WordAlignment &wa = pp.getWordAlignment();
+		WordAlignment::const_iterator wit = wa.begin_for_target(i);
+		if(wit != wa.end_for_target(i)) {
+			uint first = *wit;
+			if(++wit == wa.end_for_target(i))
+				return pp.getSourceWordIds()[first];
 		}
-	}
 
-	uint getAlignPairFreq(const std::string& p1, const std::string& p2) const {
-		return pMap.find(p1)->second.find(p2)->second.freq;
+		std::string ss = "";
+		for(WordAlignment::const_iterator it = wa.begin_for_target(i); it != wa.end_for_target(i); ++it)
+			ss += pp.getSourcePhrase().get()[*it];
+		return Vocabulary::getId(ss);
 	}
 
-	float getAlignSpread(const std::string& p) const {
-		return pMap.find(p)->second.size();
+	void addPhrasePair(const AnchoredPhrasePair& app) {
+		const PhrasePairData &pp = app.second.get();
+		const std::vector<WordId> &td = pp.getTargetWordIds();
+		for (uint i=0; i<td.size(); ++i)
+			counts.add(getAlignedSource(pp, i), td[i]);
 	}
 
-	float scoreAll(const AlignMap& pm) const {
-		float score = 0;
-		float numPairs = 0;
-		for (AlignPairMap_::const_iterator it1=pMap.begin() ; it1 != pMap.end(); it1++ ) {
-			//q-VALUE = TPF / (TpS + SpT)
-			AlignScore_ ps = it1->second;
-			for (AlignScore_::const_iterator it2=ps.begin() ; it2 != ps.end(); it2++ ) {
-				//weight the score by the number of occurences of the phrase pair
-				float newScore = it2->second.freq * it2->second.freq/(it1->second.size() + pm.getAlignSpread(it2->first));
-				score += newScore;
-				numPairs += it2->second.freq;
-			}
-		}
-		return score/numPairs;
+	virtual ConsistencyQModelWordState *clone() const {
+		return new ConsistencyQModelWordState(*this);
 	}
 };
 
-
-struct ConsistencyQModelWordState
-:	public FeatureFunction::State,
-	public FeatureFunction::StateModifications
+struct ConsistencyQModelWordModifications
+:	public FeatureFunction::StateModifications
 {
-	ConsistencyQModelWordState(uint nsents) : oldScore(0) {}
-
-	AlignMap s2t;
-	AlignMap t2s;
-
-	float oldScore;
-
-	Float score() {
-		oldScore = log(s2t.scoreAll(t2s));
-		return oldScore;
-	}
-
-	void addPhrasePair(const AnchoredPhrasePair& app) {
-		PhraseData td = app.second.get().getTargetPhrase().get();
-		WordAlignment wa = app.second.get().getWordAlignment();
-		for (uint i=0; i<td.size(); ++i) {
-			std::string ts = td[i];
-			std::string ss = "";
-			for(WordAlignment::const_iterator wit = wa.begin_for_target(i);
-				wit != wa.end_for_target(i); ++wit) {
-				ss += app.second.get().getSourcePhrase().get()[*wit];
-			}
+	ConsistencyQModelWordModifications() : qsum(0), total(0) {}
 
-			s2t.addAlignPair(ss,ts);
-			t2s.addAlignPair(ts,ss);
-		}
-	}
+	ConsistencyQCounts<WordId>::Delta pairs;
+	double qsum;
+	uint total;
 
-	void removePhrasePair(const AnchoredPhrasePair& app) {
-		PhraseData td = app.second.get().getTargetPhrase().get();
-		WordAlignment wa = app.second.get().getWordAlignment();
+	void addPhrasePair(const AnchoredPhrasePair& app, int n) {
+		const PhrasePairData &pp = app.second.get();
+		const std::vector<WordId> &td = pp.getTargetWordIds();
 		for (uint i=0; i<td.size(); ++i) {
-			std::string ts = td[i];
-			std::string ss = "";
-			for(WordAlignment::const_iterator wit = wa.begin_for_target(i);
-				wit != wa.end_for_target(i); ++wit) {
-				ss += app.second.get().getSourcePhrase().get()[*wit];
-			}
-
-			s2t.removeAlignPair(ss,ts);
-			t2s.removeAlignPair(ts,ss);
+			WordId ss = ConsistencyQModelWordState::getAlignedSource(pp, i);
+			pairs.add(ConsistencyQCounts<WordId>::KeyPair(ss, td[i]), n);
 		}
 	}
-
-	virtual ConsistencyQModelWordState *clone() const {
-		return new ConsistencyQModelWordState(*this);
-	}
 };
 
 
@@ -176,7 +98,7 @@ FeatureFunction::State
 	const DocumentState &doc,
 	Scores::iterator sbegin
 ) const {
-	const std::vector<PhraseSegmentation> &segs = doc.getPhraseSegmentations();
+	const PhraseSegmentationVector &segs = doc.getPhraseSegmentations();
 
 	ConsistencyQModelWordState *s = new ConsistencyQModelWordState(segs.size());
 	for(uint i = 0; i < segs.size(); i++) {
@@ -186,6 +108,7 @@ FeatureFunction::State
 	}
 
 
+	s->counts.computeScore();
 	*sbegin = s->score();
 	return s;
 }
@@ -208,7 +131,7 @@ FeatureFunction::StateModifications
 ) const {
 	const ConsistencyQModelWordState *prevstate =
 		dynamic_cast<const ConsistencyQModelWordState *>(state);
-	ConsistencyQModelWordState *s = prevstate->clone();
+	ConsistencyQModelWordModifications *s = new ConsistencyQModelWordModifications();
 
 	const std::vector<SearchStep::Modification> &mods = step.getModifications();
 	for(std::vector<SearchStep::Modification>::const_iterator
@@ -222,16 +145,17 @@ FeatureFunction::StateModifications
 			PhraseSegmentation::const_iterator to_it = it->to_it;
 
 			for(PhraseSegmentation::const_iterator pit=from_it; pit != to_it; pit++) {
-				s->removePhrasePair(*pit);
+				s->addPhrasePair(*pit, -1);
 			}
 
 			BOOST_FOREACH(const AnchoredPhrasePair &app, it->proposal) {
-				s->addPhrasePair(app);
+				s->addPhrasePair(app, 1);
 			}
 		}
 	}
 
-	*sbegin = s->score();
+	prevstate->counts.computeUpdate(s->pairs, s->qsum, s->total);
+	*sbegin = ConsistencyQCounts<WordId>::score(s->qsum, s->total);
 	return s;
 }
 
@@ -253,9 +177,8 @@ FeatureFunction::State
 	FeatureFunction::StateModifications *modif
 ) const {
 	ConsistencyQModelWordState *os = dynamic_cast<ConsistencyQModelWordState *>(oldState);
-	ConsistencyQModelWordState *ms = dynamic_cast<ConsistencyQModelWordState *>(modif);
+	ConsistencyQModelWordModifications *ms = dynamic_cast<ConsistencyQModelWordModifications *>(modif);
 
-	os->s2t.swap(ms->s2t);
-	os->t2s.swap(ms->t2s);
+	os->counts.apply(ms->pairs, ms->qsum, ms->total);
 	return oldState;
 }
@@ -0,0 +1,119 @@
+/*
+ *  CountDelta.h
+ *
+ *  Copyright 2012 by Christian Hardmeier. All rights reserved.
+ *
+ *  This file is part of Docent, a document-level decoder for phrase-based
+ *  statistical machine translation.
+ *
+ *  Docent is free software: you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation, either version 3 of the License, or (at your option) any later
+ *  version.
+ *
+ *  Docent is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  Docent. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef docent_CountDelta_h
+#define docent_CountDelta_h
+
+#include "Docent.h"
+
+#include <utility>
+#include <vector>
+
+/**
+ * Changes to a table of counts, recorded against a shared table that is
+ * not modified until the changes are applied. Document-level models use
+ * this to score a search step without copying their whole document state:
+ * estimateScoreUpdate records the words added and removed by the step in a
+ * CountDelta, and applyStateModifications applies it to the table of the
+ * document state. The table can be any map from Key to uint.
+ *
+ * A search step only touches a few phrases, so the changes are kept in a
+ * short vector and searched linearly.
+ */
+template<class Key>
+class CountDelta {
+public:
+	typedef std::pair<Key,int> Change;
+	typedef std::vector<Change> ChangeList;
+
+private:
+	ChangeList changes_;
+
+	template<class Map>
+	static uint getBaseCount(const Map &base, const Key &k) {
+		typename Map::const_iterator it = base.find(k);
+		return it == base.end() ? 0 : it->second;
+	}
+
+public:
+	void add(const Key &k, int n = 1) {
+		for(typename ChangeList::iterator it = changes_.begin(); it != changes_.end(); ++it)
+			if(it->first == k) {
+				it->second += n;
+				return;
+			}
+		changes_.push_back(Change(k, n));
+	}
+
+	void remove(const Key &k) {
+		add(k, -1);
+	}
+
+	bool empty() const {
+		return changes_.empty();
+	}
+
+	void clear() {
+		changes_.clear();
+	}
+
+	const ChangeList &getChanges() const {
+		return changes_;
+	}
+
+	// Net change of the count of k.
+	int get(const Key &k) const {
+		for(typename ChangeList::const_iterator it = changes_.begin(); it != changes_.end(); ++it)
+			if(it->first == k)
+				return it->second;
+		return 0;
+	}
+
+	// Count of k in base after the changes.
+	template<class Map>
+	uint getCount(const Map &base, const Key &k) const {
+		return getBaseCount(base, k) + get(k);
+	}
+
+	// Net change of the sum of all counts.
+	int getTotal() const {
+		int d = 0;
+		for(typename ChangeList::const_iterator it = changes_.begin(); it != changes_.end(); ++it)
+			d += it->second;
+		return d;
+	}
+
+	// Applies the changes to base, removing the keys whose count drops to zero.
+	template<class Map>
+	void apply(Map &base) const {
+		for(typename ChangeList::const_iterator it = changes_.begin(); it != changes_.end(); ++it) {
+			if(it->second == 0)
+				continue;
+			uint &c = base[it->first];
+			c += it->second;
+			if(c == 0)
+				base.erase(it->first);
+		}
+	}
+};
+
+#endif
@@ -66,6 +66,10 @@ public:
 		return 1;
 	}
 
+	virtual Float getEvaluationCost() const {
+		return 0.1;
+	}
+
 	virtual void computeSentenceScores(
 		const DocumentState &doc,
 		uint sentno,
@@ -89,7 +93,7 @@ FeatureFunction::State
 	Scores::iterator sbegin
 ) const {
 	using namespace boost::lambda;
-	const std::vector<PhraseSegmentation> &segs = doc.getPhraseSegmentations();
+	const PhraseSegmentationVector &segs = doc.getPhraseSegmentations();
 	Float &s = *sbegin;
 	s = Float(0);
 	for(uint i = 0; i < segs.size(); i++)
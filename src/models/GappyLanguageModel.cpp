@@ -427,7 +427,7 @@ struct GappyLanguageModelState
 		PhraseData sd = app.second.get().getSourcePhrase().get();
 		PhraseData td = app.second.get().getTargetPhrase().get();
 
-		uint wordno = app.first.find_first();
+		uint wordno = app.first.start;
 		boost::smatch what;
 
 		uint addCount = 0;
@@ -658,7 +658,7 @@ FeatureFunction::State
 	const DocumentState &doc,
 	Scores::iterator sbegin
 ) const {
-	const std::vector<PhraseSegmentation> &segs = doc.getPhraseSegmentations();
+	const PhraseSegmentationVector &segs = doc.getPhraseSegmentations();
 
 	boost::shared_ptr<const MMAXDocument> mmax = doc.getInputDocument();
 	// const MarkableLevel &annotationLevel = mmax->getMarkableLevel(selectedAnnotation);
@@ -776,7 +776,7 @@ FeatureFunction::StateModifications
 	uint phrNo = 0;
 	int phrNoDiff = 0;
 
-	const std::vector<PhraseSegmentation> &segs = doc.getPhraseSegmentations();
+	const PhraseSegmentationVector &segs = doc.getPhraseSegmentations();
 	const uint docSize = segs.size();
 
 	uint lmOrder = model_->Order();
@@ -24,6 +24,7 @@
 #include "SearchStep.h"
 #include "models/GeometricDistortionModel.h"
 
+#include <cstdlib>
 #include <limits>
 #include <vector>
 
@@ -37,15 +38,11 @@ GeometricDistortionModel::GeometricDistortionModel(
 }
 
 inline Float GeometricDistortionModel::computeDistortionDistance(
-	const CoverageBitmap &m1,
-	const CoverageBitmap &m2
+	const SourceSpan &m1,
+	const SourceSpan &m2
 ) const {
-	uint fp1 = m1.find_first();
-	CoverageBitmap::size_type fp1n;
-	while((fp1n = m1.find_next(fp1)) != CoverageBitmap::npos)
-		fp1 = fp1n;
-	uint fp2 = m2.find_first();
-	return static_cast<Float>(-abs(fp2 - (fp1 + 1)));
+	int distance = int(m2.start) - int(m1.end());
+	return static_cast<Float>(-std::abs(distance));
 }
 
 template<class Operator>
@@ -75,7 +72,7 @@ FeatureFunction::State
 	const DocumentState &doc,
 	Scores::iterator sbegin
 ) const {
-	const std::vector<PhraseSegmentation> &segs = doc.getPhraseSegmentations();
+	const PhraseSegmentationVector &segs = doc.getPhraseSegmentations();
 	std::fill_n(sbegin, getNumberOfScores(), .0);
 	for(uint i = 0; i < segs.size(); i++)
 		scoreSegment(segs[i].begin(), segs[i].end(), sbegin, std::plus<Float>());
@@ -36,8 +36,8 @@ private:
 	) const;
 
 	Float computeDistortionDistance(
-		const CoverageBitmap &m1,
-		const CoverageBitmap &m2
+		const SourceSpan &m1,
+		const SourceSpan &m2
 	) const;
 
 	Float distortionLimit_;
@@ -68,6 +68,10 @@ public:
 		return distortionLimit_ == -1 ? 1 : 2;
 	}
 
+	virtual Float getEvaluationCost() const {
+		return 0.1;
+	}
+
 	virtual void computeSentenceScores(
 		const DocumentState &doc,
 		uint sentno,
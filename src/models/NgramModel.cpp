@@ -22,13 +22,16 @@
 
 #include "Docent.h"
 
+#include "CopyOnWriteVector.h"
 #include "DocumentState.h"
 #include "models/NgramModel.h"
 #include "PhrasePair.h"
 #include "PiecewiseIterator.h"
 #include "SearchStep.h"
+#include "Vocabulary.h"
 
 #include <algorithm>
+#include <limits>
 #include <vector>
 
 #include<iostream>
@@ -37,7 +40,10 @@
 #include "lm/binary_format.hh"
 #include "lm/model.hh"
 
+#include <boost/cstdint.hpp>
 #include <boost/foreach.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
 
 template<class Model> struct NgramDocumentState;
 template<class Model> struct NgramDocumentModifications;
@@ -58,17 +64,52 @@ private:
 	typedef std::pair<StateType_,Float> WordState_;
 	typedef std::vector<WordState_> SentenceState_;
 
+	struct ScoreCacheEntry_ {
+		StateType_ context;
+		lm::WordIndex word;
+		WordState_ result;
+	};
+
+	// Data each thread keeps for itself so that it can be used without a lock.
+	struct ThreadCache_ {
+		const NgramModel *model;
+		// LM indices of the words in the global vocabulary, looked up by
+		// string the first time the thread scores a word.
+		std::vector<lm::WordIndex> indices;
+		// Direct-mapped memo of recent n-gram scores, indexed by the hash of
+		// the context state and the word. Local search rescores the same
+		// contexts over and over, and probing a large LM mostly misses the
+		// processor cache.
+		std::vector<ScoreCacheEntry_> scores;
+		boost::uint64_t scoreLookups;
+		boost::uint64_t scoreHits;
+
+		ThreadCache_(const NgramModel *m);
+		~ThreadCache_();
+	};
+
 	mutable Logger logger_;
 
 	Model *model_;
 
+	uint scoreCacheSize_;
+	mutable boost::thread_specific_ptr<ThreadCache_> threadCaches_;
+	mutable boost::mutex statsMutex_;
+	mutable boost::uint64_t scoreLookups_;
+	mutable boost::uint64_t scoreHits_;
+
+	ThreadCache_ &getThreadCache() const;
+	lm::WordIndex getIndex(ThreadCache_ &cache, WordId word) const;
+
 	NgramModel(
 		const std::string &file,
 		const int annotationLevel,
-		const bool tokenFlag
+		const bool tokenFlag,
+		const uint scoreCacheSize
 	);
 
 	Float scoreNgram(
+		ThreadCache_ &cache,
 		const StateType_ &old_state,
 		lm::WordIndex word,
 		WordState_ &out_state
@@ -137,6 +178,7 @@ FeatureFunction
 
 	int annotationLevel = params.get<uint>("annotation-level", -1);
 	bool tokenFlag = params.get<bool>("token-flag", false);
+	uint scoreCacheSize = params.get<uint>("score-cache-size", 0);
 
 	std::string smtype = params.get<std::string>("model-type", "");
 
@@ -162,13 +204,13 @@ FeatureFunction
 		if(!smtype.empty() && smtype != "hash-probing")
 			LOG(logger, error, "Incorrect LM type in configuration "
 				"for file " << file);
-		return new NgramModel<lm::ngram::ProbingModel>(file,annotationLevel,tokenFlag);
+		return new NgramModel<lm::ngram::ProbingModel>(file,annotationLevel,tokenFlag,scoreCacheSize);
 
 	case lm::ngram::TRIE_SORTED:
 		if(!smtype.empty() && smtype != "trie-sorted")
 			LOG(logger, error, "Incorrect LM type in configuration "
 				"for file " << file);
-		return new NgramModel<lm::ngram::TrieModel>(file,annotationLevel,tokenFlag);
+		return new NgramModel<lm::ngram::TrieModel>(file,annotationLevel,tokenFlag,scoreCacheSize);
 
 /*
 	case lm::ngram::QUANT_TRIE_SORTED:
@@ -187,7 +229,8 @@ FeatureFunction
 
 template<class M>
 struct NgramDocumentState : public FeatureFunction::State {
-	std::vector<typename M::SentenceState_> lmCache;
+	// Shared with the copies of this state until a sentence is modified.
+	CopyOnWriteVector<typename M::SentenceState_> lmCache;
 
 	virtual FeatureFunction::State *clone() const {
 		return new NgramDocumentState(*this);
@@ -209,21 +252,56 @@ template<class M>
 NgramModel<M>::NgramModel(
 	const std::string &file,
 	const int annotationLevel,
-	const bool tokenFlag
-) :	logger_("NgramModel")
+	const bool tokenFlag,
+	const uint scoreCacheSize
+) :	logger_("NgramModel"),
+	scoreLookups_(0),
+	scoreHits_(0)
 {
 	model_ = new M(file.c_str());
 	annotationLevel_ = annotationLevel;
 	tokenFlag_ = tokenFlag;
 	LOG(logger_, debug, "Annotation level of N-gram model set to " << annotationLevel_);
 	LOG(logger_, debug, "Token flag set to " << tokenFlag_);
+
+	// round down to a power of two so the hash can be masked
+	scoreCacheSize_ = 0;
+	if(scoreCacheSize > 0)
+		for(scoreCacheSize_ = 1; scoreCacheSize_ <= scoreCacheSize / 2; scoreCacheSize_ *= 2)
+			;
+	if(scoreCacheSize_ > 0)
+		LOG(logger_, verbose, "N-gram score cache of " << scoreCacheSize_ << " entries ("
+			<< scoreCacheSize_ * sizeof(ScoreCacheEntry_) / 1024 << " kB per thread)");
 }
 
 template<class M>
 NgramModel<M>::~NgramModel() {
+	threadCaches_.reset();
+	if(scoreCacheSize_ > 0 && scoreLookups_ > 0)
+		LOG(logger_, verbose, "N-gram score cache: " << scoreHits_ << " hits in "
+			<< scoreLookups_ << " lookups (" << 100 * scoreHits_ / scoreLookups_ << "%)");
 	delete model_;
 }
 
+template<class M>
+NgramModel<M>::ThreadCache_::ThreadCache_(
+	const NgramModel *m
+) :	model(m),
+	scoreLookups(0),
+	scoreHits(0)
+{
+	ScoreCacheEntry_ empty;
+	empty.word = std::numeric_limits<lm::WordIndex>::max();
+	scores.resize(model->scoreCacheSize_, empty);
+}
+
+template<class M>
+NgramModel<M>::ThreadCache_::~ThreadCache_() {
+	boost::mutex::scoped_lock lock(model->statsMutex_);
+	model->scoreLookups_ += scoreLookups;
+	model->scoreHits_ += scoreHits;
+}
+
 template<class M>
 FeatureFunction::State
 *NgramModel<M>::initDocument(
@@ -231,17 +309,18 @@ FeatureFunction::State
 	Scores::iterator sbegin
 ) const {
 	NgramDocumentState_ *state = new NgramDocumentState_();
-	const std::vector<PhraseSegmentation> &segs = doc.getPhraseSegmentations();
+	const PhraseSegmentationVector &segs = doc.getPhraseSegmentations();
 	state->lmCache.resize(segs.size());
 	Float &s = *sbegin;
 	for(uint i = 0; i < segs.size(); i++) {
-		state->lmCache[i].resize(countTargetWords(segs[i].begin(), segs[i].end()) + 1); // one for </s>
+		SentenceState_ &cache = state->lmCache.modify(i);
+		cache.resize(countTargetWords(segs[i].begin(), segs[i].end()) + 1); // one for </s>
 		s += scorePhraseSegmentation<true>(
 			&model_->BeginSentenceState(),
 			segs[i].begin(),
 			segs[i].end(),
 			segs[i].end(),
-			state->lmCache[i].begin(),
+			cache.begin(),
 			true
 		);
 	}
@@ -287,15 +366,14 @@ FeatureFunction::StateModifications
 		PhraseSegmentation::const_iterator from_it = it->from_it;
 		PhraseSegmentation::const_iterator to_it = it->to_it;
 
-		const PhraseSegmentation &current = doc.getPhraseSegmentation(sentno);
-		uint clear_from = countTargetWords(current.begin(), from_it);
-		uint w_to = clear_from + countTargetWords(from_it, to_it);
+		uint clear_from = doc.getTargetWordOffset(sentno, from_it);
+		uint w_to = doc.getTargetWordOffset(sentno, to_it);
 		uint clear_to = w_to + model_->Order() - 1;
 
 		// don't clear further than to the start of the next modification
 		++it;
 		if(it != mods.end() && it->sentno == sentno) {
-			uint next_from = w_to + countTargetWords(to_it, it->from_it);
+			uint next_from = doc.getTargetWordOffset(sentno, it->from_it);
 			if(next_from < clear_to)
 				clear_to = next_from;
 		}
@@ -351,7 +429,7 @@ FeatureFunction::StateModifications
 		typename SentenceState_::const_iterator oldstate1 = state.lmCache[sentno].begin();
 		PhraseSegmentation::const_iterator next_from_it = it1->from_it;
 		typename SentenceState_::const_iterator oldstate2 = oldstate1 +
-			countTargetWords(current.begin(), next_from_it);
+			doc.getTargetWordOffset(sentno, next_from_it);
 		sntstate.insert(sntstate.end(), oldstate1, oldstate2);
 
 		// keep a copy of the last state to avoid problems with invalidating iterators
@@ -391,7 +469,7 @@ FeatureFunction::StateModifications
 			pieces.push_back(next_from_it);
 
 			uint state_pos = sntstate.size();
-			oldstate1 = oldstate2 + countTargetWords(from_it, to_it);
+			oldstate1 = oldstate2 + doc.countTargetWords(sentno, from_it, to_it);
 
 			for(typename SentenceState_::const_iterator pit = oldstate2; pit != oldstate1; ++pit) {
 				LOG(logger_, debug, "(a) minus " << pit->second);
@@ -402,7 +480,7 @@ FeatureFunction::StateModifications
 			if(last_mod_in_sentence)
 				oldstate2 = state.lmCache[sentno].end(); // also take along the </s> token
 			else
-				oldstate2 = oldstate1 + countTargetWords(to_it, next_from_it);
+				oldstate2 = oldstate1 + doc.countTargetWords(sentno, to_it, next_from_it);
 
 			sntstate.insert(sntstate.end(), oldstate1, oldstate2);
 
@@ -437,19 +515,61 @@ FeatureFunction::State
 		it != mod->modifications.end();
 		++it
 	)
-		state.lmCache[it->first].swap(it->second);
+		state.lmCache.swapElement(it->first, it->second);
 	return oldState;
 }
 
+template<class M>
+typename NgramModel<M>::ThreadCache_ &NgramModel<M>::getThreadCache() const {
+	ThreadCache_ *cache = threadCaches_.get();
+	if(cache == NULL) {
+		cache = new ThreadCache_(this);
+		threadCaches_.reset(cache);
+	}
+	return *cache;
+}
+
+template<class M>
+inline lm::WordIndex NgramModel<M>::getIndex(
+	ThreadCache_ &cache,
+	WordId word
+) const {
+	std::vector<lm::WordIndex> &table = cache.indices;
+	const lm::WordIndex unresolved = std::numeric_limits<lm::WordIndex>::max();
+	if(word >= table.size())
+		table.resize(word + 1, unresolved);
+	if(table[word] == unresolved)
+		table[word] = model_->GetVocabulary().Index(Vocabulary::getWord(word));
+	return table[word];
+}
+
 template<class M>
 inline Float NgramModel<M>::scoreNgram(
+	ThreadCache_ &cache,
 	const StateType_ &state,
 	lm::WordIndex word,
 	WordState_ &out_state
 ) const {
+	ScoreCacheEntry_ *entry = NULL;
+	if(scoreCacheSize_ > 0) {
+		cache.scoreLookups++;
+		entry = &cache.scores[hash_value(state, word) & (scoreCacheSize_ - 1)];
+		if(entry->word == word && entry->context == state) {
+			cache.scoreHits++;
+			out_state = entry->result;
+			return out_state.second;
+		}
+	}
+
 	Float s = model_->Score(state, word, out_state.first);
 	s *= Float(2.30258509299405); // log10 -> ln
 	out_state.second = s;
+
+	if(entry) {
+		entry->context = state;
+		entry->word = word;
+		entry->result = out_state;
+	}
 	return s;
 }
 
@@ -464,6 +584,7 @@ Float NgramModel<M>::scorePhraseSegmentation(
 	bool atEos
 ) const {
 	const VocabularyType_ &vocab = model_->GetVocabulary();
+	ThreadCache_ &cache = getThreadCache();
 
 	PhrasePairIterator ng_it = from_it;
 
@@ -473,17 +594,15 @@ Float NgramModel<M>::scorePhraseSegmentation(
 	Float s = .0;
 	while(ng_it != to_it) {
 		LOG(logger_, debug, "running (a) loop");
-		for(PhraseData::const_iterator
-			wi = ng_it->second.get().getTargetPhraseOrAnnotations(annotationLevel_,tokenFlag_).get().begin();
-			wi != ng_it->second.get().getTargetPhraseOrAnnotations(annotationLevel_,tokenFlag_).get().end();
-			++wi
-		) {
-			Float lscore = scoreNgram(*last_state, vocab.Index(*wi), *state_it);
+		const std::vector<WordId> &words =
+			ng_it->second.get().getTargetWordIdsOrAnnotations(annotationLevel_,tokenFlag_);
+		for(std::vector<WordId>::const_iterator wi = words.begin(); wi != words.end(); ++wi) {
+			Float lscore = scoreNgram(cache, *last_state, getIndex(cache, *wi), *state_it);
 			// old score has already been subtracted
 			last_state = &state_it->first;
 			++state_it;
 			s += lscore;
-			LOG(logger_, debug, "(a) plus " << lscore << "\t" << *wi);
+			LOG(logger_, debug, "(a) plus " << lscore << "\t" << Vocabulary::getWord(*wi));
 		}
 		++ng_it;
 	}
@@ -494,11 +613,9 @@ Float NgramModel<M>::scorePhraseSegmentation(
 	while(!ScoreCompleteSentence && ng_it != eos && !independent) {
 		LOG(logger_, debug, "running (b) loop");
 
-		for(PhraseData::const_iterator
-			wi = ng_it->second.get().getTargetPhraseOrAnnotations(annotationLevel_,tokenFlag_).get().begin();
-			wi != ng_it->second.get().getTargetPhraseOrAnnotations(annotationLevel_,tokenFlag_).get().end();
-			++wi
-		) {
+		const std::vector<WordId> &words =
+			ng_it->second.get().getTargetWordIdsOrAnnotations(annotationLevel_,tokenFlag_);
+		for(std::vector<WordId>::const_iterator wi = words.begin(); wi != words.end(); ++wi) {
 
 			if(future > last_state->Length() && future > last_statelen) {
 				LOG(logger_, debug, "breaking, future = " << future
@@ -513,11 +630,11 @@ Float NgramModel<M>::scorePhraseSegmentation(
 			last_statelen = state_it->first.Length();
 			s -= state_it->second;
 			LOG(logger_, debug, "(b) minus " << state_it->second);
-			Float lscore = scoreNgram(*last_state, vocab.Index(*wi), *state_it);
+			Float lscore = scoreNgram(cache, *last_state, getIndex(cache, *wi), *state_it);
 			last_state = &state_it->first;
 			++state_it;
 			s += lscore;
-			LOG(logger_, debug, "(b) plus " << lscore << "\t" << *wi);
+			LOG(logger_, debug, "(b) plus " << lscore << "\t" << Vocabulary::getWord(*wi));
 		}
 		++ng_it;
 	}
@@ -531,7 +648,7 @@ Float NgramModel<M>::scorePhraseSegmentation(
 			s -= state_it->second;
 			LOG(logger_, debug, "(c) minus " << state_it->second);
 		}
-		Float lscore = scoreNgram(*last_state, vocab.EndSentence(), *state_it);
+		Float lscore = scoreNgram(cache, *last_state, vocab.EndSentence(), *state_it);
 		s += lscore;
 		LOG(logger_, debug, "(c) plus " << lscore << "\t</s>");
 	}
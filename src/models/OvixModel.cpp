@@ -24,47 +24,55 @@
 
 #include "DocumentState.h"
 #include "SearchStep.h"
-
-#include <map>
+#include "models/CountDelta.h"
+#include "models/WordCounts.h"
 
 #include <boost/foreach.hpp>
 
 struct OvixModelState
-:	public FeatureFunction::State,
-	public FeatureFunction::StateModifications
+:	public FeatureFunction::State
 {
-	OvixModelState(uint nsents) : tokens(0) {} // :  sentencePairs(nsents) {}
+	OvixModelState(uint nsents) {} // :  sentencePairs(nsents) {}
 
-	typedef std::map<Word,uint> TypeMap_;
+	WordCounts words;
 
-	TypeMap_ types;
-	uint tokens;
+	static Float score(uint typeSize, uint ntokens) {
+		return -log(ntokens)/log(2-(log(typeSize)/log(ntokens+1)));
+	}
 
-	Float score() {
-		uint typeSize = types.size();
-		return -log(tokens)/log(2-(log(typeSize)/log(tokens+1)));
+	Float score() const {
+		return score(words.getTypes(), words.getTokens());
 	}
 
 	void addPhrasePair(const AnchoredPhrasePair& app) {
-		BOOST_FOREACH(const Word &w, app.second.get().getTargetPhrase().get()) {
-			tokens++;
-			types[w]++;
-		}
+		BOOST_FOREACH(WordId w, app.second.get().getTargetWordIds())
+			words.add(w);
+	}
+
+	virtual OvixModelState *clone() const {
+		return new OvixModelState(*this);
+	}
+};
+
+struct OvixModelModifications
+:	public FeatureFunction::StateModifications
+{
+	CountDelta<WordId> words;
+
+	void addPhrasePair(const AnchoredPhrasePair& app) {
+		BOOST_FOREACH(WordId w, app.second.get().getTargetWordIds())
+			words.add(w);
 	}
 
 	void removePhrasePair(const AnchoredPhrasePair& app) {
-		BOOST_FOREACH(const Word &w, app.second.get().getTargetPhrase().get()) {
-			tokens--;
-			if (types.find(w)->second == 1) {
-				types.erase(w);
-			} else {
-				types[w]--;
-			}
-		}
+		BOOST_FOREACH(WordId w, app.second.get().getTargetWordIds())
+			words.remove(w);
 	}
 
-	virtual OvixModelState *clone() const {
-		return new OvixModelState(*this);
+	Float score(const OvixModelState &s) const {
+		return OvixModelState::score(
+			s.words.getTypes(words),
+			s.words.getTokens(words));
 	}
 };
 
@@ -74,7 +82,7 @@ FeatureFunction::State
 	const DocumentState &doc,
 	Scores::iterator sbegin
 ) const {
-	const std::vector<PhraseSegmentation> &segs = doc.getPhraseSegmentations();
+	const PhraseSegmentationVector &segs = doc.getPhraseSegmentations();
 
 	OvixModelState *s = new OvixModelState(segs.size());
 	for(uint i = 0; i < segs.size(); i++) {
@@ -104,7 +112,7 @@ FeatureFunction::StateModifications
 	Scores::iterator sbegin
 ) const {
 	const OvixModelState *prevstate = dynamic_cast<const OvixModelState *>(state);
-	OvixModelState *s = prevstate->clone();
+	OvixModelModifications *s = new OvixModelModifications();
 
 	const std::vector<SearchStep::Modification> &mods = step.getModifications();
 	for(std::vector<SearchStep::Modification>::const_iterator
@@ -128,7 +136,7 @@ FeatureFunction::StateModifications
 
 	}
 
-	*sbegin = s->score();
+	*sbegin = s->score(*prevstate);
 	return s;
 }
 
@@ -150,10 +158,9 @@ FeatureFunction::State
 	FeatureFunction::StateModifications *modif
 ) const {
 	OvixModelState *os = dynamic_cast<OvixModelState *>(oldState);
-	OvixModelState *ms = dynamic_cast<OvixModelState *>(modif);
+	OvixModelModifications *ms = dynamic_cast<OvixModelModifications *>(modif);
 
-	os->types.swap(ms->types);
-	os->tokens = ms->tokens;
+	os->words.apply(ms->words);
 
 	return oldState;
 }
@@ -34,6 +34,8 @@
 #include "quering.hh"  // from ProbingPT
 
 #include <boost/algorithm/string.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/foreach.hpp>
 #include <boost/function.hpp>
@@ -42,8 +44,12 @@
 #include <boost/lambda/algorithm.hpp>
 #include <boost/lambda/bind.hpp>
 #include <boost/lambda/numeric.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/vector.hpp>
 
+#include <fstream>
 #include <iostream>
+#include <map>
 #include <ostream>
 #include <sstream>
 #include <string>
@@ -51,10 +57,10 @@
 
 
 PhraseTable::PhraseTable(
-	const Parameters &params,
-	Random random
+	const Parameters &params
 ) :	logger_("PhraseTable"),
-	random_(random)
+	backend_(NULL),
+	optionCache_(params.get<uint>("cache-size", 100000))
 {
 	filename_         = params.get<std::string>("file");
 	nscores_          = params.get<uint>("nscores", 4);
@@ -63,6 +69,16 @@ PhraseTable::PhraseTable(
 	filterLimit_      = params.get<uint>("filter-limit"      , 30);
 	filterScoreIndex_ = params.get<uint>("filter-score-index", 2);
 
+	std::string ranking = params.get<std::string>("filter-ranking", "score");
+	if(ranking == "score")
+		filterByWeightedScore_ = false;
+	else if(ranking == "weighted")
+		filterByWeightedScore_ = true;
+	else {
+		LOG(logger_, error, "Unknown filter ranking: " << ranking);
+		BOOST_THROW_EXCEPTION(ConfigurationException());
+	}
+
 	if(filterScoreIndex_ >= nscores_) {
 		LOG(logger_, error,
 			"'filter-score-index' (" << filterScoreIndex_ << ") must be less than "
@@ -75,11 +91,17 @@ PhraseTable::PhraseTable(
 		LOG(logger_, error, "phrase table not found: '" << filename_ << "'");
 		BOOST_THROW_EXCEPTION(FileFormatException());
 	}
-	try {
-		backend_ = new QueryEngine(filename_.c_str());
-	} catch(std::exception &) {
-		LOG(logger_, error, "incomplete or invalid phrase table in '" << filename_ << "'");
-		BOOST_THROW_EXCEPTION(FileFormatException());
+
+	// A missing lookup file isn't an error so that the same configuration
+	// can be used to create it with phrasecache-docent.
+	std::string lookupFile = params.get<std::string>("lookup-file", "");
+	if(!lookupFile.empty() && boost::filesystem::exists(lookupFile))
+		loadLookups(lookupFile);
+	else {
+		if(!lookupFile.empty())
+			LOG(logger_, normal, "Phrase lookup file '" << lookupFile << "' not found, "
+				"querying the phrase table directly.");
+		getBackend();
 	}
 }
 
@@ -87,6 +109,19 @@ PhraseTable::~PhraseTable() {
 	delete backend_;
 }
 
+QueryEngine &PhraseTable::getBackend() const {
+	boost::mutex::scoped_lock lock(backendMutex_);
+	if(!backend_) {
+		try {
+			backend_ = new QueryEngine(filename_.c_str());
+		} catch(std::exception &) {
+			LOG(logger_, error, "incomplete or invalid phrase table in '" << filename_ << "'");
+			BOOST_THROW_EXCEPTION(FileFormatException());
+		}
+	}
+	return *backend_;
+}
+
 inline Scores PhraseTable::scorePhraseSegmentation(
 	const PhraseSegmentation &ps
 ) const {
@@ -101,9 +136,9 @@ FeatureFunction::State
 	const DocumentState &doc,
 	Scores::iterator sbegin
 ) const {
-	const std::vector<PhraseSegmentation> &segs = doc.getPhraseSegmentations();
+	const PhraseSegmentationVector &segs = doc.getPhraseSegmentations();
 	Scores s(nscores_);
-	for(std::vector<PhraseSegmentation>::const_iterator
+	for(PhraseSegmentationVector::const_iterator
 		it = segs.begin();
 		it != segs.end();
 		++it
@@ -170,79 +205,272 @@ PhraseTable::getPhrasesForSentence(
 	const std::vector<Word> &sentence
 ) const
 {
-	using namespace boost::lambda;
 	LOG(logger_, verbose, "getPhrasesForSentence " << sentence);
 	boost::shared_ptr<PhrasePairCollection> ptc(
-		new PhrasePairCollection(sentence.size(), random_)
+		new PhrasePairCollection(sentence.size())
 	);
-	std::pair<bool, std::vector<target_text> > query_result;
-	std::map<uint, std::string> vocabids = backend_->getVocab();
 
-	CoverageBitmap cov(sentence.size());
+	// ProbingPT identifies source words by their hash values.
+	std::vector<uint64_t> srcids;
+	srcids.reserve(sentence.size());
+	BOOST_FOREACH(const Word &w, sentence)
+		srcids.push_back(getHash(StringPiece(w)));
+
 	CoverageBitmap uncovered(sentence.size());
 	uncovered.set();
 
 	for(uint i = 0; i < sentence.size(); ++i) {
-		cov.reset();
 		std::vector<Word> srcphrase;
-		std::ostringstream src("");
 		for(uint j = 0;
 			j < maxPhraseLength_ && i + j < sentence.size();
 			++j
 		) {
-			if(src.tellp() > 0)
-				src << ' ';
-			src << sentence[i + j];
-
-			query_result = backend_->query(StringPiece(src.str()));
 			srcphrase.push_back(sentence[i + j]);
-			cov.set(i + j);
+			SourceSpan span(i, j + 1);
 
-			if(!query_result.first)
+			TranslationOptions options = getTranslationOptions(srcphrase, &srcids[i]);
+			if(!options)
 				continue;
 
-			std::vector<target_text> finds(query_result.second);
-			BOOST_FOREACH(target_text find, finds) {
-				std::string phrase(getTargetWordsFromIDs(find.target_phrase, &vocabids));
-				boost::trim(phrase);
+			BOOST_FOREACH(const PhrasePair &pp, *options)
+				ptc->addPhrasePair(span, pp);
+			uncovered.reset(span.start, span.length);
+		}
+	}
+
+	// add OOV phrase pairs
+	for(CoverageBitmap::size_type i = uncovered.find_first();
+		i != CoverageBitmap::npos;
+		i = uncovered.find_next(i)
+	)
+		ptc->addPhrasePair(SourceSpan(i, 1), PhrasePair(sentence[i], Scores(nscores_, 0)));
+
+	return ptc;
+}
 
-				std::vector<Word> tokens;
-				boost::split(tokens, phrase, boost::is_any_of(" "));
-				LOG(logger_, verbose, i << "/" << j << " > " << tokens.size() << " TOKENS: [" << tokens << "]");
 
-				PhraseAndAnnotationsPair factors(
-					getFactors(tokens)
-				);
+PhraseTable::TranslationOptions
+PhraseTable::getTranslationOptions(
+	const std::vector<Word> &srcphrase,
+	const uint64_t *srcids
+) const
+{
+	LookupMap_::const_iterator it = savedLookups_.find(srcphrase);
+	if(it != savedLookups_.end())
+		return it->second;
+
+	TranslationOptions options;
+	if(!optionCache_.find(srcphrase, options)) {
+		options = lookupTranslationOptions(srcphrase, srcids);
+		optionCache_.insert(srcphrase, options);
+	}
+	return options;
+}
 
-				WordAlignment wa(
-					getWordAlignment(srcphrase, tokens, find)
-				);
 
-				Scores scores;
-				scores.reserve(find.prob.size());
-				BOOST_FOREACH(Float prob, find.prob)
-					scores.push_back(std::log(prob));
+PhraseTable::TranslationOptions
+PhraseTable::lookupTranslationOptions(
+	const std::vector<Word> &srcphrase,
+	const uint64_t *srcids
+) const
+{
+	// getBackend() locks, so it is called once and not for every token.
+	QueryEngine &backend = getBackend();
+	std::vector<target_text> finds;
+	if(!backend.query(srcids, srcphrase.size(), finds))
+		return TranslationOptions();
+	filterTranslationOptions(finds);
+
+	boost::shared_ptr<std::vector<PhrasePair> > options(new std::vector<PhrasePair>());
+	options->reserve(finds.size());
+	BOOST_FOREACH(const target_text &find, finds) {
+		std::vector<Word> tokens;
+		tokens.reserve(find.target_phrase.size());
+		BOOST_FOREACH(uint id, find.target_phrase)
+			tokens.push_back(backend.getTargetWord(id));
+		LOG(logger_, verbose, srcphrase << " > " << tokens.size() << " TOKENS: [" << tokens << "]");
+
+		PhraseAndAnnotationsPair factors(
+			getFactors(tokens)
+		);
 
-				PhrasePair pp(PhrasePairData(
-					srcphrase, factors.first, factors.second, wa, scores
-				));
-				ptc->addPhrasePair(cov, pp);
+		WordAlignment wa(
+			getWordAlignment(srcphrase, tokens, find)
+		);
+
+		Scores scores;
+		scores.reserve(find.prob.size());
+		BOOST_FOREACH(Float prob, find.prob)
+			scores.push_back(std::log(prob));
+
+		options->push_back(PhrasePair(PhrasePairData(
+			srcphrase, factors.first, factors.second, wa, scores
+		)));
+	}
+	return options;
+}
+
+
+void PhraseTable::setFilterWeights(
+	const std::vector<Float> &weights
+) {
+	filterWeights_ = weights;
+
+	if(filterByWeightedScore_ && !savedLookups_.empty() && savedFilterWeights_ != filterWeights_) {
+		LOG(logger_, error, "The phrase lookup file was filtered with different phrase table weights.");
+		BOOST_THROW_EXCEPTION(ConfigurationException());
+	}
+}
+
+
+// The header of a lookup file records the settings that affect the
+// translation options, so that a file doesn't silently get used with a
+// different phrase table configuration.
+static const std::string lookupFileMagic = "docent-phrase-lookups";
+static const uint lookupFileVersion = 1;
+
+void PhraseTable::saveLookups(
+	const std::vector<std::vector<Word> > &sentences,
+	const std::string &file
+) const
+{
+	std::map<std::vector<Word>,TranslationOptions> lookups;
+	BOOST_FOREACH(const std::vector<Word> &sentence, sentences) {
+		std::vector<uint64_t> srcids;
+		srcids.reserve(sentence.size());
+		BOOST_FOREACH(const Word &w, sentence)
+			srcids.push_back(getHash(StringPiece(w)));
+
+		for(uint i = 0; i < sentence.size(); ++i) {
+			std::vector<Word> srcphrase;
+			for(uint j = 0; j < maxPhraseLength_ && i + j < sentence.size(); ++j) {
+				srcphrase.push_back(sentence[i + j]);
+				if(lookups.find(srcphrase) == lookups.end())
+					lookups.insert(std::make_pair(srcphrase, getTranslationOptions(srcphrase, &srcids[i])));
 			}
-			uncovered -= cov;
 		}
 	}
 
-	// add OOV phrase pairs
-	for(CoverageBitmap::size_type i = uncovered.find_first();
-		i != CoverageBitmap::npos;
-		i = uncovered.find_next(i)
+	std::ofstream ofs(file.c_str(), std::ios::binary);
+	if(!ofs.good()) {
+		LOG(logger_, error, "Can't write phrase lookup file '" << file << "'");
+		BOOST_THROW_EXCEPTION(FileFormatException());
+	}
+
+	boost::archive::binary_oarchive oa(ofs);
+	uint nlookups = lookups.size();
+	oa << lookupFileMagic << lookupFileVersion;
+	oa << filename_ << nscores_ << maxPhraseLength_ << annotationCount_;
+	oa << filterLimit_ << filterScoreIndex_ << filterByWeightedScore_ << filterWeights_;
+	oa << nlookups;
+	typedef std::pair<const std::vector<Word>,TranslationOptions> LookupPair;
+	BOOST_FOREACH(const LookupPair &l, lookups) {
+		bool found = (l.second != NULL);
+		oa << l.first << found;
+		if(found)
+			oa << *l.second;
+	}
+
+	LOG(logger_, normal, "Saved " << nlookups << " phrase lookups to '" << file << "'");
+}
+
+void PhraseTable::loadLookups(
+	const std::string &file
+) {
+	std::ifstream ifs(file.c_str(), std::ios::binary);
+	if(!ifs.good()) {
+		LOG(logger_, error, "Can't read phrase lookup file '" << file << "'");
+		BOOST_THROW_EXCEPTION(FileFormatException());
+	}
+
+	boost::archive::binary_iarchive ia(ifs);
+
+	std::string magic;
+	uint version;
+	ia >> magic >> version;
+	if(magic != lookupFileMagic || version != lookupFileVersion) {
+		LOG(logger_, error, "'" << file << "' is not a phrase lookup file of this version of Docent.");
+		BOOST_THROW_EXCEPTION(FileFormatException());
+	}
+
+	std::string filename;
+	uint nscores, maxPhraseLength, annotationCount, filterLimit, filterScoreIndex;
+	bool filterByWeightedScore;
+	ia >> filename >> nscores >> maxPhraseLength >> annotationCount;
+	ia >> filterLimit >> filterScoreIndex >> filterByWeightedScore >> savedFilterWeights_;
+	if(filename != filename_ || nscores != nscores_ || maxPhraseLength != maxPhraseLength_
+		|| annotationCount != annotationCount_ || filterLimit != filterLimit_
+		|| filterScoreIndex != filterScoreIndex_ || filterByWeightedScore != filterByWeightedScore_
 	) {
-		cov.reset();
-		cov.set(i);
-		ptc->addPhrasePair(cov, PhrasePair(sentence[i], Scores(nscores_, 0)));
+		LOG(logger_, error, "The phrase lookup file '" << file << "' was made with a different "
+			"phrase table configuration.");
+		BOOST_THROW_EXCEPTION(ConfigurationException());
 	}
 
-	return ptc;
+	uint nlookups;
+	ia >> nlookups;
+	savedLookups_.rehash(nlookups);
+	for(uint i = 0; i < nlookups; i++) {
+		std::vector<Word> srcphrase;
+		bool found;
+		ia >> srcphrase >> found;
+		TranslationOptions options;
+		if(found) {
+			boost::shared_ptr<std::vector<PhrasePair> > o(new std::vector<PhrasePair>());
+			ia >> *o;
+			options = o;
+		}
+		savedLookups_.insert(std::make_pair(srcphrase, options));
+	}
+
+	LOG(logger_, normal, "Loaded " << nlookups << " phrase lookups from '" << file << "'");
+}
+
+
+// Log score used for ranking options with a score of 0, as in Moses.
+static const Float filterLogZero = -100;
+
+// Keeps the filterLimit_ best translation options, in their original order.
+// Options of equal score are ranked in the order of the phrase table.
+void PhraseTable::filterTranslationOptions(
+	std::vector<target_text> &finds
+) const
+{
+	if(filterLimit_ == 0 || finds.size() <= filterLimit_)
+		return;
+
+	std::vector<std::pair<Float,uint> > ranking;
+	ranking.reserve(finds.size());
+	for(uint i = 0; i < finds.size(); i++) {
+		const std::vector<float> &prob = finds[i].prob;
+		Float score;
+		if(filterByWeightedScore_) {
+			score = 0;
+			for(uint k = 0; k < prob.size() && k < filterWeights_.size(); k++) {
+				// 0 * log(0) would make the score NaN and the sort order undefined
+				if(filterWeights_[k] == 0)
+					continue;
+				score += filterWeights_[k] * (prob[k] > 0 ? std::log(prob[k]) : filterLogZero);
+			}
+		} else
+			score = filterScoreIndex_ < prob.size() ? prob[filterScoreIndex_] : 0;
+		// negated so that sorting in ascending order puts the best first
+		ranking.push_back(std::make_pair(-score, i));
+	}
+
+	std::partial_sort(ranking.begin(), ranking.begin() + filterLimit_, ranking.end());
+
+	std::vector<uint> keep;
+	keep.reserve(filterLimit_);
+	for(uint i = 0; i < filterLimit_; i++)
+		keep.push_back(ranking[i].second);
+	std::sort(keep.begin(), keep.end());
+
+	std::vector<target_text> filtered;
+	filtered.reserve(filterLimit_);
+	BOOST_FOREACH(uint i, keep)
+		filtered.push_back(finds[i]);
+	finds.swap(filtered);
 }
 
 
@@ -26,11 +26,14 @@
 #include "Docent.h"
 
 #include "FeatureFunction.h"
+#include "LRUCache.h"
 #include "PhrasePair.h"
 
 #include "quering.hh"  // from ProbingPT
 
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
 #include <boost/utility.hpp>
 
 class PhrasePairCollection;
@@ -38,20 +41,56 @@ class PhrasePairCollection;
 class PhraseTable : public FeatureFunction, boost::noncopyable {
 private:
 	typedef std::pair< std::vector<Word>, std::vector<Phrase> > PhraseAndAnnotationsPair;
+	// NULL if the source phrase is not in the phrase table
+	typedef boost::shared_ptr<const std::vector<PhrasePair> > TranslationOptions;
+	typedef boost::unordered_map<std::vector<Word>,TranslationOptions> LookupMap_;
 
 	Logger logger_;
-	Random random_;
 	std::string filename_;
 	uint nscores_;
 	uint maxPhraseLength_;
 	uint annotationCount_;
 	uint filterLimit_;
 	uint filterScoreIndex_;
-	QueryEngine *backend_;
+	bool filterByWeightedScore_;
+	std::vector<Float> filterWeights_;
+	mutable QueryEngine *backend_;
+	mutable boost::mutex backendMutex_;
 	bool loadAlignments_;
 
+	// Translation options loaded from a file written by phrasecache-docent.
+	// If there is such a file, the phrase table itself is only opened when
+	// a source phrase is missing from it.
+	LookupMap_ savedLookups_;
+	std::vector<Float> savedFilterWeights_;
+
+	// Decoded translation options of recently used source phrases, shared by
+	// all sentences and documents. Recurring source phrases are frequent in
+	// a test set, and decoding the phrase table entries is expensive.
+	mutable LRUCache<std::vector<Word>,TranslationOptions> optionCache_;
+
 	Scores scorePhraseSegmentation(const PhraseSegmentation &ps) const;
 
+	QueryEngine &getBackend() const;
+
+	void loadLookups(const std::string &file);
+
+	TranslationOptions
+	getTranslationOptions(
+		const std::vector<Word> &srcphrase,
+		const uint64_t *srcids
+	) const;
+
+	TranslationOptions
+	lookupTranslationOptions(
+		const std::vector<Word> &srcphrase,
+		const uint64_t *srcids
+	) const;
+
+	void filterTranslationOptions(
+		std::vector<target_text> &finds
+	) const;
+
 	PhraseAndAnnotationsPair
 	getFactors(
 		const std::vector<Word> &tokens
@@ -65,7 +104,7 @@ private:
 	) const;
 
 public:
-	PhraseTable(const Parameters &params, Random random);
+	PhraseTable(const Parameters &params);
 	virtual ~PhraseTable();
 
 	virtual State *initDocument(
@@ -93,16 +132,34 @@ public:
 		return nscores_;
 	}
 
+	virtual Float getEvaluationCost() const {
+		return 0.1;
+	}
+
 	virtual void computeSentenceScores(
 		const DocumentState &doc,
 		uint sentno,
 		Scores::iterator sbegin
 	) const;
 
+	// Called with the weights of the phrase table scores once they are known.
+	// With weighted filtering, the translation options of a source phrase are
+	// ranked by their weighted score.
+	void setFilterWeights(
+		const std::vector<Float> &weights
+	);
+
 	boost::shared_ptr<const PhrasePairCollection> getPhrasesForSentence(
 		const std::vector<Word> &sentence
 	) const;
 
+	// Looks up all source phrases of the sentences and saves the results to
+	// file, to be loaded by later runs with the parameter "lookup-file".
+	void saveLookups(
+		const std::vector<std::vector<Word> > &sentences,
+		const std::string &file
+	) const;
+
 	bool operator==(const PhraseTable &o) const {
 		return filename_ == o.filename_;
 	}
@@ -265,7 +265,7 @@ struct SelectedPOSLMState
 		PhraseData sd = app.second.get().getSourcePhrase().get();
 		PhraseData td = app.second.get().getTargetPhrase().get();
 
-		uint wordno = app.first.find_first();
+		uint wordno = app.first.start;
 		smatch what;
 
 		uint addCount=0;
@@ -390,7 +390,7 @@ FeatureFunction::State
 	const DocumentState &doc,
 	Scores::iterator sbegin
 ) const {
-	const std::vector<PhraseSegmentation> &segs = doc.getPhraseSegmentations();
+	const PhraseSegmentationVector &segs = doc.getPhraseSegmentations();
 
 	boost::shared_ptr<const MMAXDocument> mmax = doc.getInputDocument();
 	const MarkableLevel &posLevel = mmax->getMarkableLevel("pos");
@@ -473,7 +473,7 @@ FeatureFunction::StateModifications
 	uint phrNo = 0;
 	int phrNoDiff = 0;
 
-	const std::vector<PhraseSegmentation> &segs = doc.getPhraseSegmentations();
+	const PhraseSegmentationVector &segs = doc.getPhraseSegmentations();
 	const uint docSize = segs.size();
 
 	uint lmOrder = model_->Order();
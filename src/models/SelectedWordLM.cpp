@@ -352,7 +352,7 @@ FeatureFunction::State
 	const DocumentState &doc,
 	Scores::iterator sbegin
 ) const {
-	const std::vector<PhraseSegmentation> &segs = doc.getPhraseSegmentations();
+	const PhraseSegmentationVector &segs = doc.getPhraseSegmentations();
 	SelectedWordLMState *s = new SelectedWordLMState(segs.size());
 
 	for(uint i = 0; i < segs.size(); i++) {
@@ -411,7 +411,7 @@ FeatureFunction::StateModifications
 	uint phrNo = 0;
 	int phrNoDiff = 0;
 
-	const std::vector<PhraseSegmentation> &segs = doc.getPhraseSegmentations();
+	const PhraseSegmentationVector &segs = doc.getPhraseSegmentations();
 	const uint docSize = segs.size();
 
 	uint lmOrder = model_->Order();
@@ -22,6 +22,7 @@
 
 #include "models/SemanticSimilarityModel.h"
 
+#include "CopyOnWriteVector.h"
 #include "DocumentState.h"
 #include "SearchStep.h"
 #include "MMAXDocument.h"
@@ -87,8 +88,9 @@ struct SemanticSimilarityModelState
 		MaxWordSize = 50;
 	};
 
-	std::vector< std::vector< SelectedWordVector > > selectedWords;
-	std::vector< std::vector< std::string > > posTags;
+	// Copies of the state share the sentences they have not modified.
+	CopyOnWriteVector< std::vector< SelectedWordVector > > selectedWords;
+	CopyOnWriteVector< std::vector< std::string > > posTags;
 	std::vector<float> sim;
 
 	float *M;
@@ -195,12 +197,12 @@ struct SemanticSimilarityModelState
 	}
 
 	void GetHistory(
-		std::vector<SelectedWordVector*> &history,
+		std::vector<const SelectedWordVector*> &history,
 		uint sentNo,
 		const uint size
 	) {
 		while(history.size() < size) {
-			std::vector<SelectedWordVector>::iterator it=selectedWords[sentNo].end();
+			std::vector<SelectedWordVector>::const_iterator it=selectedWords[sentNo].end();
 			while(it != selectedWords[sentNo].begin()) {
 				it--;
 				history.push_back(&(*it));
@@ -213,12 +215,12 @@ struct SemanticSimilarityModelState
 	}
 
 	void GetHistory(
-		std::vector<SelectedWordVector*> &history,
+		std::vector<const SelectedWordVector*> &history,
 		uint sentNo,
 		const uint idx,
 		const uint size
 	) {
-		std::vector<SelectedWordVector>::iterator
+		std::vector<SelectedWordVector>::const_iterator
 			it = selectedWords[sentNo].begin()+idx;
 		while(history.size() < size) {
 			while(it!=selectedWords[sentNo].begin()) {
@@ -235,14 +237,14 @@ struct SemanticSimilarityModelState
 	}
 
 	void GetFuture(
-		std::vector<SelectedWordVector*> &future,
+		std::vector<const SelectedWordVector*> &future,
 		uint sentNo,
 		const uint idx,
 		const uint size,
 		const uint stopSentNo,
 		const uint stopPhrNo
 	) {
-		std::vector<SelectedWordVector>::iterator
+		std::vector<SelectedWordVector>::const_iterator
 			it = selectedWords[sentNo].begin()+idx;
 		while(future.size() < size) {
 			while(it != selectedWords[sentNo].end()) {
@@ -290,7 +292,8 @@ struct SemanticSimilarityModelState
 	void ClearWords(
 		const uint sentNo
 	) {
-		selectedWords[sentNo].clear();
+		std::vector<SelectedWordVector> empty;
+		selectedWords.swapElement(sentNo, empty);
 	};
 
 	void CopyWords(
@@ -303,9 +306,10 @@ struct SemanticSimilarityModelState
 		for(uint i=0; i<state.selectedWords[sentno].size(); i++) {
 			if(state.selectedWords[sentno][i].phrNo >= start) {
 				if(state.selectedWords[sentno][i].phrNo < end) {
-					selectedWords[sentno].push_back(state.selectedWords[sentno][i]);
+					std::vector<SelectedWordVector> &words = selectedWords.modify(sentno);
+					words.push_back(state.selectedWords[sentno][i]);
 					if(diff != 0)
-						selectedWords[sentno][selectedWords[sentno].size()-1].phrNo += diff;
+						words.back().phrNo += diff;
 				}
 			}
 		}
@@ -316,7 +320,7 @@ struct SemanticSimilarityModelState
 		const uint wordno,
 		const std::string& pos
 	) {
-		posTags[sentno].push_back(pos);
+		posTags.modify(sentno).push_back(pos);
 	};
 
 	uint AddWord(
@@ -330,7 +334,7 @@ struct SemanticSimilarityModelState
 		PhraseData sd = app.second.get().getSourcePhrase().get();
 		PhraseData td = app.second.get().getTargetPhrase().get();
 
-		uint wordno = app.first.find_first();
+		uint wordno = app.first.start;
 
 		uint addCount = 0;
 		for(uint j = 0; j < sd.size(); ++j) {
@@ -347,12 +351,13 @@ struct SemanticSimilarityModelState
 						continue;
 					SelectedWordVector word(phrno,*wit,sd[j],td[*wit],wordno,size);
 					FindVector(b,word.vec);
-					selectedWords[sentno].push_back(word);
-					selectedWords[sentno].back().similarity = MaxSimilarityWithHistory(
+					selectedWords.modify(sentno).push_back(word);
+					float similarity = MaxSimilarityWithHistory(
 						sentno,
 						selectedWords[sentno].size()-1,
 						historySize
 					);
+					selectedWords.modify(sentno).back().similarity = similarity;
 					// currentScore += word.similarity;
 					addCount++;
 					//LOG(logger_, debug, "add word " << td[*wit] << " aligned to " << sd[j]);
@@ -368,11 +373,12 @@ struct SemanticSimilarityModelState
 		const uint idx,
 		const uint size
 	) {
-		selectedWords[sentNo][idx].similarity = MaxSimilarityWithHistory(
+		float similarity = MaxSimilarityWithHistory(
 			sentNo,
 			idx,
 			size
 		);
+		selectedWords.modify(sentNo)[idx].similarity = similarity;
 	};
 
 	float MaxSimilarityWithHistory(
@@ -380,11 +386,11 @@ struct SemanticSimilarityModelState
 		const uint idx,
 		const uint size
 	) {
-		std::vector<SelectedWordVector*> history;
+		std::vector<const SelectedWordVector*> history;
 		GetHistory(history,sentNo,idx,size);
 		float maxSim = 0;
 		while(!history.empty()) {
-			SelectedWordVector *last = history.back();
+			const SelectedWordVector *last = history.back();
 			float sim = CosinusSimilarity(
 				selectedWords[sentNo][idx].vec,
 				last->vec
@@ -482,7 +488,7 @@ FeatureFunction::State
 	const DocumentState &doc,
 	Scores::iterator sbegin
 ) const {
-	const std::vector<PhraseSegmentation> &segs = doc.getPhraseSegmentations();
+	const PhraseSegmentationVector &segs = doc.getPhraseSegmentations();
 
 	boost::shared_ptr<const MMAXDocument> mmax = doc.getInputDocument();
 	const MarkableLevel &posLevel = mmax->getMarkableLevel("pos");
@@ -544,7 +550,7 @@ FeatureFunction::StateModifications
 	uint phrNo = 0;
 	int phrNoDiff = 0;
 
-	const std::vector<PhraseSegmentation> &segs = doc.getPhraseSegmentations();
+	const PhraseSegmentationVector &segs = doc.getPhraseSegmentations();
 	const uint docSize = segs.size();
 
 	// run through all modifications and check if we need to update the word list
@@ -571,7 +577,7 @@ FeatureFunction::StateModifications
 			s->CopyWords(*prevstate,sentNo,0,phrNo,phrNoDiff);
 
 			// get the LM history before the modification (initialize LM states)
-			std::vector<SelectedWordVector*> history;
+			std::vector<const SelectedWordVector*> history;
 			s->GetHistory(history,sentNo,HistorySize-1);
 		}
 
@@ -22,6 +22,7 @@
 
 #include "Docent.h"
 
+#include "CopyOnWriteVector.h"
 #include "DocumentState.h"
 #include "SemanticSpace.h"
 #include "models/SemanticSpaceLanguageModel.h"
@@ -195,6 +196,12 @@ public:
 	virtual uint getNumberOfScores() const {
 		return 1;
 	}
+
+	// The estimate is free, but scoring requires a vector computation for
+	// each word in the context window.
+	virtual Float getEvaluationCost() const {
+		return 10;
+	}
 };
 
 FeatureFunction *SemanticSpaceLanguageModelFactory::createSemanticSpaceLanguageModel(const Parameters &params) {
@@ -202,7 +209,8 @@ FeatureFunction *SemanticSpaceLanguageModelFactory::createSemanticSpaceLanguageM
 }
 
 struct SSLMDocumentState : public FeatureFunction::State {
-	std::vector<SemanticSpaceLanguageModel::SentenceState_> wordcache;
+	// Shared with the copies of this state until a sentence is modified.
+	CopyOnWriteVector<SemanticSpaceLanguageModel::SentenceState_> wordcache;
 	SemList semlist;
 
 	uint targetWordCount;
@@ -335,7 +343,7 @@ SemanticSpaceLanguageModel::~SemanticSpaceLanguageModel() {
 
 FeatureFunction::State *SemanticSpaceLanguageModel::initDocument(const DocumentState &doc, Scores::iterator sbegin) const {
 	SSLMDocumentState *state = new SSLMDocumentState();
-	const std::vector<PhraseSegmentation> &segs = doc.getPhraseSegmentations();
+	const PhraseSegmentationVector &segs = doc.getPhraseSegmentations();
 	state->wordcache.resize(segs.size());
 	Float &s = *sbegin;
 	state->vectorCount = 0;
@@ -344,18 +352,19 @@ FeatureFunction::State *SemanticSpaceLanguageModel::initDocument(const DocumentS
 		uint ntgtwords = countTargetWords(segs[i].begin(), segs[i].end());
 		total_tgtwords += ntgtwords;
 		LOG(logger_, debug, "Sentence " << i << ": " << ntgtwords << " target words.");
-		state->wordcache[i].reserve(ntgtwords);
+		SentenceState_ &cache = state->wordcache.modify(i);
+		cache.reserve(ntgtwords);
 		BOOST_FOREACH(const AnchoredPhrasePair &app, segs[i]) {
 			for(uint w = 0; w < app.second.get().getTargetPhrase().get().size(); w++) {
 				ScoreVectorPair_ svp = lookupWord(app.second, w);
 				if(svp.second == NULL) {
 					if(vectorCountModel_ == NULL) {
 						WordState_ ws(svp.first, noSemLink_);
-						state->wordcache[i].push_back(ws);
+						cache.push_back(ws);
 						s += svp.first;
 					} else {
 						WordState_ ws(Float(0), noSemLink_);
-						state->wordcache[i].push_back(ws);
+						cache.push_back(ws);
 					}
 				} else {
 					state->vectorCount++;
@@ -364,12 +373,12 @@ FeatureFunction::State *SemanticSpaceLanguageModel::initDocument(const DocumentS
 					WordState_ ws(svp.first, semit);
 					Float lscore = scoreWord(semit, state->semlist.begin());
 					ws.score = lscore;
-					state->wordcache[i].push_back(ws);
+					cache.push_back(ws);
 					s += lscore;
 				}
 			}
 		}
-		assert(state->wordcache[i].size() == ntgtwords);
+		assert(cache.size() == ntgtwords);
 	}
 
 	if(vectorCountModel_ != NULL) {
@@ -420,10 +429,8 @@ FeatureFunction::StateModifications *SemanticSpaceLanguageModel::updateScore(con
 		PhraseSegmentation::const_iterator to_it = mods[i].to_it;
 		const PhraseSegmentation &proposal = mods[i].proposal;
 
-		const PhraseSegmentation &current = doc.getPhraseSegmentation(sentno);
-
-		uint fromword = countTargetWords(current.begin(), from_it);
-		uint toword = fromword + countTargetWords(from_it, to_it);
+		uint fromword = doc.getTargetWordOffset(sentno, from_it);
+		uint toword = doc.getTargetWordOffset(sentno, to_it);
 
 		// find out what to replace in the semantic vector list
 		SemList::const_iterator oldsem_start;
@@ -564,7 +571,7 @@ FeatureFunction::StateModifications *SemanticSpaceLanguageModel::updateScore(con
 		SentenceState_::const_iterator oldstate1 = state.wordcache[sentno].begin();
 		PhraseSegmentation::const_iterator next_from_it = it1->from_it;
 		SentenceState_::const_iterator oldstate2 = oldstate1 +
-			countTargetWords(current.begin(), next_from_it);
+			doc.getTargetWordOffset(sentno, next_from_it);
 
 		if(sntstate->empty())
 			sntstate->insert(sntstate->end(), oldstate1, oldstate2);
@@ -643,7 +650,7 @@ FeatureFunction::StateModifications *SemanticSpaceLanguageModel::updateScore(con
 					oldstate1 = state.wordcache[sentno].begin();
 					if(sentno == next_sentence)
 						oldstate2 = oldstate1 +
-							countTargetWords(doc.getPhraseSegmentation(sentno).begin(), next_from_it);
+							doc.getTargetWordOffset(sentno, next_from_it);
 					else
 						oldstate2 = state.wordcache[sentno].end();
 				}
@@ -697,7 +704,7 @@ FeatureFunction::State *SemanticSpaceLanguageModel::applyStateModifications(Feat
 	SSLMDocumentModifications *mod = dynamic_cast<SSLMDocumentModifications *>(modif);
 	for(std::vector<std::pair<uint,SentenceState_> >::iterator it = mod->wordcacheMods.begin();
 			it != mod->wordcacheMods.end(); ++it)
-		state.wordcache[it->first].swap(it->second);
+		state.wordcache.swapElement(it->first, it->second);
 	BOOST_FOREACH(SemListModification &m, mod->semlistMods) {
 		// transform const_iterators into iterators
 		SemList::iterator from = state.semlist.begin();
@@ -51,11 +51,11 @@ FeatureFunction::State
 	const DocumentState &doc,
 	Scores::iterator sbegin
 ) const {
-	const std::vector<PhraseSegmentation> &segs = doc.getPhraseSegmentations();
+	const PhraseSegmentationVector &segs = doc.getPhraseSegmentations();
 	Float &s = *sbegin;
 	s = Float(0);
 	for(uint i = 0; i < segs.size(); i++)
-		s += score(doc.getInputSentenceLength(i), countTargetWords(segs[i]));
+		s += score(doc.getInputSentenceLength(i), doc.getTargetWordCount(i));
 	return NULL;
 }
 
@@ -81,7 +81,7 @@ FeatureFunction::StateModifications
 		PhraseSegmentation::const_iterator to_it = it->to_it;
 		const PhraseSegmentation &proposal = it->proposal;
 
-		Float outlen = Float(countTargetWords(doc.getPhraseSegmentation(sentno)));
+		Float outlen = Float(doc.getTargetWordCount(sentno));
 		s -= score(doc.getInputSentenceLength(sentno), outlen);
 
 		std::for_each(
@@ -116,7 +116,7 @@ void SentenceLengthModel::computeSentenceScores(
 ) const {
 	*sbegin = score(
 		doc.getInputSentenceLength(sentno),
-		countTargetWords(doc.getPhraseSegmentation(sentno))
+		doc.getTargetWordCount(sentno)
 	);
 }
 
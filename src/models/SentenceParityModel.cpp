@@ -23,33 +23,38 @@
 #include "models/SentenceParityModel.h"
 
 #include "DocumentState.h"
-#include "Counters.h"
 #include "SearchStep.h"
 
-#include <boost/lambda/lambda.hpp>
-#include <boost/lambda/bind.hpp>
+#include <utility>
+#include <vector>
 
 struct SentenceParityModelState
-:	public FeatureFunction::State,
-	public FeatureFunction::StateModifications
+:	public FeatureFunction::State
 {
-	SentenceParityModelState(uint nsents) : outputLength(nsents) {}
+	SentenceParityModelState(uint nsents) : outputLength(nsents), neven(0), nodd(0) {}
 
 	std::vector<uint> outputLength;
+	uint neven;
+	uint nodd;
+
+	static Float score(uint neven, uint nodd) {
+		if(neven > nodd)
+			return -Float(nodd);
+		else
+			return -Float(neven);
+	}
 
 	Float score() const {
-		uint neven = 0;
-		uint nodd = 0;
+		return score(neven, nodd);
+	}
+
+	void countParities() {
+		neven = nodd = 0;
 		for(uint i = 0; i < outputLength.size(); i++)
 			if(outputLength[i] % 2 == 0)
 				neven++;
 			else
 				nodd++;
-
-		if(neven > nodd)
-			return -Float(nodd);
-		else
-			return -Float(neven);
 	}
 
 	virtual SentenceParityModelState *clone() const {
@@ -57,16 +62,29 @@ struct SentenceParityModelState
 	}
 };
 
+// New output lengths of the sentences changed by a search step and the
+// resulting parity counts.
+struct SentenceParityModelModifications
+:	public FeatureFunction::StateModifications
+{
+	typedef std::vector<std::pair<uint,uint> > LengthList_;
+
+	LengthList_ outputLength;
+	uint neven;
+	uint nodd;
+};
+
 
 FeatureFunction::State *SentenceParityModel::initDocument(
 	const DocumentState &doc,
 	Scores::iterator sbegin
 ) const {
-	const std::vector<PhraseSegmentation> &segs = doc.getPhraseSegmentations();
+	const PhraseSegmentationVector &segs = doc.getPhraseSegmentations();
 
 	SentenceParityModelState *s = new SentenceParityModelState(segs.size());
 	for(uint i = 0; i < segs.size(); i++)
-		s->outputLength[i] = countTargetWords(segs[i]);
+		s->outputLength[i] = doc.getTargetWordCount(i);
+	s->countParities();
 
 	*sbegin = s->score();
 	return s;
@@ -80,29 +98,35 @@ FeatureFunction::StateModifications *SentenceParityModel::estimateScoreUpdate(
 	Scores::iterator sbegin
 ) const {
 	const SentenceParityModelState *prevstate = dynamic_cast<const SentenceParityModelState *>(state);
-	SentenceParityModelState *s = prevstate->clone();
-
-	WordPenaltyCounter counter;
+	SentenceParityModelModifications *s = new SentenceParityModelModifications();
+	typedef SentenceParityModelModifications::LengthList_ LengthList_;
 
+	// The modifications are sorted by sentence.
 	const std::vector<SearchStep::Modification> &mods = step.getModifications();
 	for(std::vector<SearchStep::Modification>::const_iterator it = mods.begin(); it != mods.end(); ++it) {
 		uint sentno = it->sentno;
-		PhraseSegmentation::const_iterator from_it = it->from_it;
-		PhraseSegmentation::const_iterator to_it = it->to_it;
-		const PhraseSegmentation &proposal = it->proposal;
-
-		using namespace boost::lambda;
-		std::for_each(
-			from_it, to_it,
-			s->outputLength[sentno] -= boost::lambda::bind(counter, _1)
-		);
-		std::for_each(
-			proposal.begin(), proposal.end(),
-			s->outputLength[sentno] += boost::lambda::bind(counter, _1)
-		);
+		if(s->outputLength.empty() || s->outputLength.back().first != sentno)
+			s->outputLength.push_back(std::make_pair(sentno, prevstate->outputLength[sentno]));
+		uint &len = s->outputLength.back().second;
+		len -= doc.countTargetWords(sentno, it->from_it, it->to_it);
+		len += countTargetWords(it->proposal);
 	}
 
-	*sbegin = s->score();
+	s->neven = prevstate->neven;
+	s->nodd = prevstate->nodd;
+	for(LengthList_::const_iterator it = s->outputLength.begin(); it != s->outputLength.end(); ++it) {
+		bool wasEven = prevstate->outputLength[it->first] % 2 == 0;
+		bool isEven = it->second % 2 == 0;
+		if(wasEven && !isEven) {
+			s->neven--;
+			s->nodd++;
+		} else if(!wasEven && isEven) {
+			s->nodd--;
+			s->neven++;
+		}
+	}
+
+	*sbegin = SentenceParityModelState::score(s->neven, s->nodd);
 	return s;
 }
 
@@ -122,8 +146,12 @@ FeatureFunction::State *SentenceParityModel::applyStateModifications(
 	FeatureFunction::StateModifications *modif
 ) const {
 	SentenceParityModelState *os = dynamic_cast<SentenceParityModelState *>(oldState);
-	SentenceParityModelState *ms = dynamic_cast<SentenceParityModelState *>(modif);
-	os->outputLength.swap(ms->outputLength);
+	SentenceParityModelModifications *ms = dynamic_cast<SentenceParityModelModifications *>(modif);
+	typedef SentenceParityModelModifications::LengthList_ LengthList_;
+	for(LengthList_::const_iterator it = ms->outputLength.begin(); it != ms->outputLength.end(); ++it)
+		os->outputLength[it->first] = it->second;
+	os->neven = ms->neven;
+	os->nodd = ms->nodd;
 	return oldState;
 }
 
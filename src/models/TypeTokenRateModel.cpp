@@ -24,52 +24,63 @@
 #include "DocumentState.h"
 #include "FeatureFunction.h"
 #include "SearchStep.h"
+#include "models/CountDelta.h"
 #include "models/TypeTokenRateModel.h"
+#include "models/WordCounts.h"
 
 #include <boost/foreach.hpp>
 
 #include <iostream>
-#include <map>
 
 using namespace std;
 
 
 struct TypeTokenRateModelState
-:	public FeatureFunction::State,
-	public FeatureFunction::StateModifications
+:	public FeatureFunction::State
 {
-	TypeTokenRateModelState(uint nsents) : tokens(0) {}
+	TypeTokenRateModelState(uint nsents) {}
 
-	typedef std::map<Word,uint> TypeMap_;
+	WordCounts words;
 
-	TypeMap_ types;
-	uint tokens;
+	static Float score(uint ntypes, uint ntokens) {
+		return log(1.0*ntypes/ntokens);
+	}
 
-	Float score() {
-		return log(1.0*types.size()/tokens);
+	Float score() const {
+		return score(words.getTypes(), words.getTokens());
 	}
 
 	void addPhrasePair(const AnchoredPhrasePair& app) {
-		BOOST_FOREACH(const Word &w, app.second.get().getTargetPhrase().get()) {
-			tokens++;
-			types[w]++;
-		}
+		BOOST_FOREACH(WordId w, app.second.get().getTargetWordIds())
+			words.add(w);
+	}
+
+	virtual TypeTokenRateModelState *clone() const {
+		return new TypeTokenRateModelState(*this);
+	}
+};
+
+// The words added and removed by a search step, recorded against the
+// document state without copying it.
+struct TypeTokenRateModelModifications
+:	public FeatureFunction::StateModifications
+{
+	CountDelta<WordId> words;
+
+	void addPhrasePair(const AnchoredPhrasePair& app) {
+		BOOST_FOREACH(WordId w, app.second.get().getTargetWordIds())
+			words.add(w);
 	}
 
 	void removePhrasePair(const AnchoredPhrasePair& app) {
-		BOOST_FOREACH(const Word &w, app.second.get().getTargetPhrase().get()) {
-			tokens--;
-			if (types.find(w)->second == 1) {
-				types.erase(w);
-			}
-			else {
-				types[w]--;
-			}
-		}
+		BOOST_FOREACH(WordId w, app.second.get().getTargetWordIds())
+			words.remove(w);
 	}
 
-	virtual TypeTokenRateModelState *clone() const {
-		return new TypeTokenRateModelState(*this);
+	Float score(const TypeTokenRateModelState &s) const {
+		return TypeTokenRateModelState::score(
+			s.words.getTypes(words),
+			s.words.getTokens(words));
 	}
 };
 
@@ -88,7 +99,7 @@ FeatureFunction::State
 	const DocumentState &doc,
 	Scores::iterator sbegin
 ) const {
-	const std::vector<PhraseSegmentation> &segs = doc.getPhraseSegmentations();
+	const PhraseSegmentationVector &segs = doc.getPhraseSegmentations();
 
 	TypeTokenRateModelState *s = new TypeTokenRateModelState(segs.size());
 	for(uint i = 0; i < segs.size(); i++) {
@@ -118,7 +129,7 @@ FeatureFunction::StateModifications
 	Scores::iterator sbegin
 ) const {
 	const TypeTokenRateModelState *prevstate = dynamic_cast<const TypeTokenRateModelState *>(state);
-	TypeTokenRateModelState *s = prevstate->clone();
+	TypeTokenRateModelModifications *s = new TypeTokenRateModelModifications();
 
 	const std::vector<SearchStep::Modification> &mods = step.getModifications();
 	for(std::vector<SearchStep::Modification>::const_iterator
@@ -141,7 +152,7 @@ FeatureFunction::StateModifications
 		}
 	}
 
-	*sbegin = s->score();
+	*sbegin = s->score(*prevstate);
 	return s;
 }
 
@@ -163,9 +174,8 @@ FeatureFunction::State
 	FeatureFunction::StateModifications *modif
 ) const {
 	TypeTokenRateModelState *os = dynamic_cast<TypeTokenRateModelState *>(oldState);
-	TypeTokenRateModelState *ms = dynamic_cast<TypeTokenRateModelState *>(modif);
+	TypeTokenRateModelModifications *ms = dynamic_cast<TypeTokenRateModelModifications *>(modif);
 
-	os->types.swap(ms->types);
-	os->tokens = ms->tokens;
+	os->words.apply(ms->words);
 	return oldState;
 }
@@ -29,8 +29,10 @@
 #include <boost/foreach.hpp>
 #include <boost/regex.hpp>
 
+#include <algorithm>
 #include <cmath>
 #include <fstream>
+#include <map>
 #include <sstream>
 #include <vector>
 
@@ -66,74 +68,109 @@ struct Tag {
 };
 
 
+// What the tags of a sentence contribute to the score of the document. Tags
+// closed within the sentence cancel out, and a closing tag that doesn't match
+// the last tag opened in the same sentence is a conflict no matter what the
+// other sentences contain. Only the remaining closing tags depend on the tags
+// left open by the preceding sentences.
+struct SentenceTagSummary {
+	SentenceTagSummary() : conflicts(0) {}
+
+	SentenceTagSummary(
+		const std::vector<Tag> &tags
+	) : conflicts(0)
+	{
+		BOOST_FOREACH(const Tag &t, tags) {
+			if(!t.closing)
+				opens.push_back(t.tag);
+			else if(opens.empty())
+				closes.push_back(t.tag);
+			else if(opens.back() != t.tag)
+				conflicts++;
+			else
+				opens.pop_back();
+		}
+	}
+
+	// Adds the tags of this sentence to the tags left open by the preceding
+	// sentences and returns the number of conflicts it causes.
+	uint append(
+		std::vector<std::string> &openTags
+	) const {
+		uint conflictCount = conflicts;
+		BOOST_FOREACH(const std::string &c, closes) {
+			if (openTags.empty() || openTags.back() != c)
+				conflictCount++;
+			else
+				openTags.pop_back();
+		}
+		openTags.insert(openTags.end(), opens.begin(), opens.end());
+		return conflictCount;
+	}
+
+	uint conflicts;
+	std::vector<std::string> closes;
+	std::vector<std::string> opens;
+};
+
+
 struct WellFormednessModelState
-:	public FeatureFunction::State,
-	public FeatureFunction::StateModifications
+:	public FeatureFunction::State
 {
 	WellFormednessModelState(
 		uint nsents
 	) : logger_("WellFormednessModel"),
-		currentScore(0),
-		requiresUpdate(false)
+		currentScore(0)
 	{
 		sentTags.resize(nsents);
 	};
 
-	std::vector< std::vector<Tag> > sentTags;
+	// tag summaries of the sentences changed by a search step
+	typedef std::map<uint,SentenceTagSummary> ChangedTags_;
+
+	std::vector<SentenceTagSummary> sentTags;
 
 	mutable Logger logger_;
 	Float currentScore;
-	bool requiresUpdate;
 
-	Float score()
-	{
-		if (requiresUpdate) {
-			std::vector<std::string> tags;
-			uint conflictCount = 0;
-
-			// tag index vector should be sorted!
-			for (uint s = 0; s != sentTags.size(); ++s) {
-				for (uint i = 0; i != sentTags[s].size(); ++i){
-					// treat closing tags
-					if (sentTags[s][i].closing){
-						if (tags.size() == 0){
-							conflictCount++;
-						} else {
-							if (tags[tags.size()-1].compare(sentTags[s][i].tag) != 0){
-								conflictCount++;
-							} else {
-								tags.pop_back();
-							}
-						}
-					} else { // treat opening tags
-						tags.push_back(sentTags[s][i].tag);
-					}
-				}
-			}
+	const SentenceTagSummary &getTags(
+		uint s,
+		const ChangedTags_ &changed
+	) const {
+		ChangedTags_::const_iterator it = changed.find(s);
+		return it == changed.end() ? sentTags[s] : it->second;
+	}
 
-			// all remaining opening tags are conflicts!
-			while (tags.size() > 0){
-				conflictCount++;
-				tags.pop_back();
-			}
-			if(currentScore < -Float(conflictCount)) {
-				LOG(logger_, debug, "improved wellformedness score: " << currentScore << " --> " << -Float(conflictCount));
-				// TODO: avoid doing this if not in DEBUG mode!
-				if(logger_.loggable(debug)) {
-					std::string tagSeq = "";
-					for (uint s = 0; s != sentTags.size(); ++s){
-						for (uint i = 0; i != sentTags[s].size(); ++i){
-							tagSeq += sentTags[s][i].tag + ' ';
-						}
-						tagSeq += "- ";
-					}
-					LOG(logger_, debug, "tag sequence: " << tagSeq << " (" << -Float(conflictCount) << ")");
+	// Score of the document with the tags of some sentences replaced. Only
+	// the unmatched tags of each sentence are looked at.
+	Float score(
+		const ChangedTags_ &changed
+	) const {
+		std::vector<std::string> tags;
+		uint conflictCount = 0;
+
+		for (uint s = 0; s != sentTags.size(); ++s)
+			conflictCount += getTags(s, changed).append(tags);
+
+		// all remaining opening tags are conflicts!
+		conflictCount += tags.size();
+
+		if(currentScore < -Float(conflictCount)) {
+			LOG(logger_, debug, "improved wellformedness score: " << currentScore << " --> " << -Float(conflictCount));
+			if(logger_.loggable(debug)) {
+				std::string tagSeq = "";
+				for (uint s = 0; s != sentTags.size(); ++s){
+					const SentenceTagSummary &st = getTags(s, changed);
+					BOOST_FOREACH(const std::string &c, st.closes)
+						tagSeq += '/' + c + ' ';
+					BOOST_FOREACH(const std::string &o, st.opens)
+						tagSeq += o + ' ';
+					tagSeq += "- ";
 				}
+				LOG(logger_, debug, "unmatched tag sequence: " << tagSeq << " (" << -Float(conflictCount) << ")");
 			}
-			currentScore = -Float(conflictCount);
 		}
-		requiresUpdate=false;
-		return currentScore;
+		return -Float(conflictCount);
 	}
 
 	virtual WellFormednessModelState *clone() const {
@@ -141,6 +178,17 @@ struct WellFormednessModelState
 	}
 };
 
+// Only the tags of the sentences that need an update are recomputed
+// by a search step. The other sentences are read from the document state.
+struct WellFormednessModelModifications
+:	public FeatureFunction::StateModifications
+{
+	WellFormednessModelModifications() : currentScore(0) {}
+
+	WellFormednessModelState::ChangedTags_ sentTags;
+	Float currentScore;
+};
+
 
 WellFormednessModel::WellFormednessModel(
 	const Parameters &params
@@ -152,30 +200,45 @@ FeatureFunction::State
 	const DocumentState &doc,
 	Scores::iterator sbegin
 ) const {
-	const std::vector<PhraseSegmentation> &segs = doc.getPhraseSegmentations();
+	const PhraseSegmentationVector &segs = doc.getPhraseSegmentations();
 
 	WellFormednessModelState *s = new WellFormednessModelState(segs.size());
 
 	static const boost::regex tagRE("\\[(.*)\\]");
 
 	for(uint i = 0; i < segs.size(); i++) {
+		std::vector<Tag> tags;
 		BOOST_FOREACH(const AnchoredPhrasePair &app, segs[i]) {
 			BOOST_FOREACH(const std::string &w, app.second.get().getTargetPhrase().get()) {
 				boost::match_results<std::string::const_iterator> result;
 				if (boost::regex_match(w, result, tagRE)){
 					Tag tag(result[1]);
-					s->sentTags[i].push_back(tag);
+					tags.push_back(tag);
 				}
 			}
 		}
+		s->sentTags[i] = SentenceTagSummary(tags);
 	}
 
-	s->requiresUpdate = true;
-	*sbegin = s->score();
+	s->currentScore = s->score(WellFormednessModelState::ChangedTags_());
+	*sbegin = s->currentScore;
 	return s;
 }
 
 
+uint WellFormednessModel::countTagConflicts(
+	const std::vector<std::vector<std::string> > &sentenceTags
+) {
+	std::vector<std::string> tags;
+	uint conflictCount = 0;
+	BOOST_FOREACH(const std::vector<std::string> &st, sentenceTags) {
+		std::vector<Tag> sentence(st.begin(), st.end());
+		conflictCount += SentenceTagSummary(sentence).append(tags);
+	}
+	return conflictCount + tags.size();
+}
+
+
 void WellFormednessModel::computeSentenceScores(
 	const DocumentState &doc,
 	uint sentno,
@@ -196,10 +259,10 @@ FeatureFunction::StateModifications
 	static const boost::regex tagRE("\\[(.*)\\]");
 
 	const WellFormednessModelState *prevstate = dynamic_cast<const WellFormednessModelState *>(state);
-	WellFormednessModelState *s = prevstate->clone();
+	WellFormednessModelModifications *s = new WellFormednessModelModifications();
 
 	// create a vector to flag sentences that need updates
-	const std::vector<PhraseSegmentation> &segs = doc.getPhraseSegmentations();
+	const PhraseSegmentationVector &segs = doc.getPhraseSegmentations();
 	std::vector<bool> requiresUpdate (segs.size(),false);
 
 	// store tags in modified regions and store modification range
@@ -266,8 +329,7 @@ FeatureFunction::StateModifications
 
 	for (uint i=0;i<segs.size();i++){
 		if (requiresUpdate[i]){
-			s->requiresUpdate = true;
-			s->sentTags[i].clear();
+			std::vector<Tag> tags;
 			// LOG(logger_, debug, "need to update sentence " << i);
 
 			const PhraseSegmentation &current = doc.getPhraseSegmentation(i);
@@ -280,7 +342,7 @@ FeatureFunction::StateModifications
 						it != modTags[i][pos].end();
 						++it
 					){
-						s->sentTags[i].push_back(*it);
+						tags.push_back(*it);
 					}
 					uint endPos = pos+modRange[i][pos];
 					while (pos<endPos){
@@ -292,17 +354,22 @@ FeatureFunction::StateModifications
 						boost::match_results<std::string::const_iterator> result;
 						if (boost::regex_match(w, result, tagRE)){
 							Tag tag(result[1]);
-							s->sentTags[i].push_back(tag);
+							tags.push_back(tag);
 						}
 					}
 					pos++;
 					pit++;
 				}
 			}
+			s->sentTags[i] = SentenceTagSummary(tags);
 		}
 	}
 
-	*sbegin = s->score();
+	if(s->sentTags.empty())
+		s->currentScore = prevstate->currentScore;
+	else
+		s->currentScore = prevstate->score(s->sentTags);
+	*sbegin = s->currentScore;
 	return s;
 }
 
@@ -325,11 +392,15 @@ FeatureFunction::State
 	FeatureFunction::StateModifications *modif
 ) const {
 	WellFormednessModelState *os = dynamic_cast<WellFormednessModelState *>(oldState);
-	WellFormednessModelState *ms = dynamic_cast<WellFormednessModelState *>(modif);
+	WellFormednessModelModifications *ms = dynamic_cast<WellFormednessModelModifications *>(modif);
 
 	os->currentScore = ms->currentScore;
-	os->requiresUpdate = ms->requiresUpdate;
-	os->sentTags.swap(ms->sentTags);
+	for(WellFormednessModelState::ChangedTags_::iterator
+		it = ms->sentTags.begin();
+		it != ms->sentTags.end();
+		++it
+	)
+		std::swap(os->sentTags[it->first], it->second);
 
 	return oldState;
 }
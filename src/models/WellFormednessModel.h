@@ -59,6 +59,10 @@ public:
 		FeatureFunction::StateModifications *modif
 	) const;
 
+	// Number of tag conflicts of a document, given the tags ("x" or "/x") of
+	// each sentence. Computed from per-sentence summaries like the score.
+	static uint countTagConflicts(const std::vector<std::vector<std::string> > &sentenceTags);
+
 	virtual uint getNumberOfScores() const {
 		return 1;
 	}
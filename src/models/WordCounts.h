@@ -0,0 +1,99 @@
+/*
+ *  WordCounts.h
+ *
+ *  Copyright 2012 by Christian Hardmeier. All rights reserved.
+ *
+ *  This file is part of Docent, a document-level decoder for phrase-based
+ *  statistical machine translation.
+ *
+ *  Docent is free software: you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation, either version 3 of the License, or (at your option) any later
+ *  version.
+ *
+ *  Docent is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  Docent. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef docent_WordCounts_h
+#define docent_WordCounts_h
+
+#include "Docent.h"
+#include "Vocabulary.h"
+#include "models/CountDelta.h"
+
+#include <vector>
+
+/**
+ * Token counts of the words of a document in a flat array indexed by
+ * vocabulary ID, with running totals of the number of tokens and of the
+ * number of different words (types). The totals after a change recorded in
+ * a CountDelta are computed in time proportional to the number of changed
+ * words.
+ */
+class WordCounts {
+private:
+	std::vector<uint> counts_;
+	uint types_;
+	uint tokens_;
+
+public:
+	WordCounts() : types_(0), tokens_(0) {}
+
+	uint getCount(WordId w) const {
+		return w < counts_.size() ? counts_[w] : 0;
+	}
+
+	uint getTypes() const {
+		return types_;
+	}
+
+	uint getTokens() const {
+		return tokens_;
+	}
+
+	void add(WordId w, int n = 1) {
+		if(w >= counts_.size())
+			counts_.resize(w + 1);
+		uint &c = counts_[w];
+		if(c == 0 && n != 0)
+			types_++;
+		c += n;
+		if(c == 0 && n != 0)
+			types_--;
+		tokens_ += n;
+	}
+
+	uint getTypes(const CountDelta<WordId> &delta) const {
+		int d = 0;
+		const CountDelta<WordId>::ChangeList &changes = delta.getChanges();
+		for(CountDelta<WordId>::ChangeList::const_iterator it = changes.begin(); it != changes.end(); ++it) {
+			if(it->second == 0)
+				continue;
+			uint oldCount = getCount(it->first);
+			uint newCount = oldCount + it->second;
+			if(oldCount == 0 && newCount != 0)
+				d++;
+			else if(oldCount != 0 && newCount == 0)
+				d--;
+		}
+		return types_ + d;
+	}
+
+	uint getTokens(const CountDelta<WordId> &delta) const {
+		return tokens_ + delta.getTotal();
+	}
+
+	void apply(const CountDelta<WordId> &delta) {
+		const CountDelta<WordId>::ChangeList &changes = delta.getChanges();
+		for(CountDelta<WordId>::ChangeList::const_iterator it = changes.begin(); it != changes.end(); ++it)
+			add(it->first, it->second);
+	}
+};
+
+#endif
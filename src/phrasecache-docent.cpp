@@ -0,0 +1,61 @@
+/*
+ *  phrasecache-docent.cpp
+ *
+ *  Copyright 2012 by Christian Hardmeier. All rights reserved.
+ *
+ *  This file is part of Docent, a document-level decoder for phrase-based
+ *  statistical machine translation.
+ *
+ *  Docent is free software: you can redistribute it and/or modify it under the
+ *  terms of the GNU General Public License as published by the Free Software
+ *  Foundation, either version 3 of the License, or (at your option) any later
+ *  version.
+ *
+ *  Docent is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along with
+ *  Docent. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <vector>
+
+#include <boost/foreach.hpp>
+
+#include "Docent.h"
+#include "DecoderConfiguration.h"
+#include "MMAXDocument.h"
+#include "NistXmlCorpus.h"
+#include "NistXmlDocument.h"
+#include "models/PhraseTable.h"
+
+void usage() {
+	std::cerr << "Usage: phrasecache-docent config.xml output-file input.xml..." << std::endl;
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	if(argc < 4)
+		usage();
+
+	ConfigurationFile cf(argv[1]);
+	DecoderConfiguration config(cf);
+	std::string outfile = argv[2];
+
+	std::vector<std::vector<Word> > sentences;
+	for(int i = 3; i < argc; i++) {
+		NistXmlCorpus testset(argv[i]);
+		BOOST_FOREACH(const NistXmlCorpus::value_type &doc, testset) {
+			boost::shared_ptr<const MMAXDocument> mmax = doc->asMMAXDocument();
+			for(uint j = 0; j < mmax->getNumberOfSentences(); j++)
+				sentences.push_back(std::vector<Word>(mmax->sentence_begin(j), mmax->sentence_end(j)));
+		}
+	}
+
+	config.getPhraseTable().saveLookups(sentences, outfile);
+	return 0;
+}